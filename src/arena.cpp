@@ -0,0 +1,76 @@
+/**************************************************************************************************************************
+
+Filename: arena.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the arena allocator declared in arena.h.
+Whether an arena is mapped only depends on its size, and a mapped arena is rounded up to whole huge pages, so
+arena_free can tell how it was allocated, and the length of the mapping, from the size alone.
+
+****************************************************************************************************************************/
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static int huge_pages=HUGE_PAGES_TRANSPARENT;
+
+
+void set_huge_pages(int mode){
+  huge_pages=mode;
+}
+
+
+
+int huge_pages_of(const char* name){
+  if(strcmp(name,"off")==0) return HUGE_PAGES_OFF;
+  if(strcmp(name,"transparent")==0) return HUGE_PAGES_TRANSPARENT;
+  if(strcmp(name,"reserved")==0) return HUGE_PAGES_RESERVED;
+  return -1;
+}
+
+
+
+//bytes a mapped arena of size takes
+static size_t mapped_size(size_t size){
+  return (size+ARENA_HUGE_PAGE-1)&~(ARENA_HUGE_PAGE-1);
+}
+
+
+
+void* arena_alloc(size_t size){
+  void* arena;
+  if(size==0) size=ARENA_ALIGN;
+  if(size<ARENA_HUGE_PAGE){
+    size=(size+ARENA_ALIGN-1)&~(size_t)(ARENA_ALIGN-1);
+    arena=aligned_alloc(ARENA_ALIGN,size);
+    if(arena!=NULL) memset(arena,0,size);
+    return arena;
+  }
+  size=mapped_size(size);
+#ifdef MAP_HUGETLB
+  if(huge_pages==HUGE_PAGES_RESERVED){
+    arena=mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0);
+    if(arena!=MAP_FAILED) return arena;
+  }
+#endif
+  arena=mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+  if(arena==MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+  if(huge_pages!=HUGE_PAGES_OFF) madvise(arena,size,MADV_HUGEPAGE);
+#endif
+  return arena;
+}
+
+
+
+void arena_free(void* arena, size_t size){
+  if(arena==NULL) return;
+  if(size==0) size=ARENA_ALIGN;
+  if(size<ARENA_HUGE_PAGE) free(arena);
+  else munmap(arena,mapped_size(size));
+}
@@ -0,0 +1,47 @@
+/**************************************************************************************************************
+
+Filename:     arena.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the arena allocator. Every cache keeps all of its blocks and
+replacement state in one arena, see cache.h, and large hash tables like the tag index of the miss classifier
+take theirs from here too. Small arenas come from the heap. Large ones are mapped straight from the kernel, so
+they start out as zero pages that are only backed by memory once they are written, and they are put on huge
+pages, so a cache of a gigabyte does not need hundreds of thousands of TLB entries to be walked through.
+
+By default large arenas ask for transparent huge pages with madvise, which the kernel may or may not give, and
+with HUGE_PAGES_OFF they are mapped on normal pages. With HUGE_PAGES_RESERVED they are taken from the pool of
+reserved huge pages instead (MAP_HUGETLB), falling back to transparent huge pages when the pool does not have
+enough of them.
+
+*****************************************************************************************************************/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+//ways large arenas can be put on huge pages
+#define HUGE_PAGES_OFF 0
+#define HUGE_PAGES_TRANSPARENT 1
+#define HUGE_PAGES_RESERVED 2
+//size of a huge page, arenas at least this big are mapped and rounded up to a whole number of them
+#define ARENA_HUGE_PAGE ((size_t)1<<21)
+//alignment of every arena, one host cache line
+#define ARENA_ALIGN 64
+
+//sets how arenas allocated from now on use huge pages, HUGE_PAGES_TRANSPARENT until it is called
+void set_huge_pages(int mode);
+//maps "off", "transparent" or "reserved" from the command line to a huge page mode, -1 for anything else
+int huge_pages_of(const char* name);
+//returns size zeroed bytes aligned to ARENA_ALIGN, or NULL if there is not enough memory
+void* arena_alloc(size_t size);
+//frees an arena, size has to be the size it was allocated with
+void arena_free(void* arena, size_t size);
+
+#endif
@@ -0,0 +1,532 @@
+/*************************************************************************************************
+
+Filename: bench.cpp
+
+Date Modified: 10/18/2026
+
+Author: Kevin Volkel
+
+Description: This file is the main file for the simulator benchmark. It measures how many accesses
+per second the cache model simulates, without any trace file I/O. Every access stream is generated in
+memory once, and then handed straight to cache_in of the L1 cache of a hierarchy built with make_cache.
+
+The suite runs every synthetic stream, sequential, strided, uniform random, Zipfian and a pointer chase,
+on every replacement policy, a range of L1 associativities, and with and without the victim cache and the L2.
+Each configuration is timed BENCH_REPEATS times and the median run is kept, along with the spread of the runs.
+For every one the accesses per second, the nanoseconds per access, the peak resident set size of the run, the
+number of misses and the hit rate of the L1 are printed, so the policies can be compared on both how well and
+how fast they run, and with -csv they are also written to a CSV file. Times are the CPU time of the thread, so
+the time the machine spends on other work is not counted. The peak resident set size is reset before every
+configuration through /proc/self/clear_refs, so it covers the stream and the caches of that configuration only.
+
+A run with -compare reads a CSV file written earlier and fails when the misses of a configuration changed, which
+means the simulated results changed. Speed is only compared once every configuration has run. The ratios of the
+rates of both runs show how much two runs of the same binary differ on this machine, and a configuration fails
+when it got slower by more than the tolerance or BENCH_NOISE standard deviations of those ratios, whichever is
+larger, and is still that much slower when it is timed again at the end, so the noise of a busy machine is not
+taken for a regression. The run also fails when the median configuration got slower by more than the tolerance.
+
+With -dispatch the old dispatch benchmark runs instead, which builds the same hierarchy with the Cache constructor,
+which checks the policies at run time on every access, and with make_cache, and prints the speedup of make_cache.
+
+usage: bench_cache [accesses] [-repeats N] [-csv FILE] [-compare FILE] [-tolerance FRACTION] [-dispatch]
+
+*****************************************************************************************************/
+#include "cache.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+
+//number of times each configuration is timed, the median run is reported
+#define BENCH_REPEATS 5
+//slowdown a configuration may have against the baseline of -compare before it fails
+#define BENCH_TOLERANCE 0.10
+//how many standard deviations of the rate ratios of all configurations a single one may be slower by
+#define BENCH_NOISE 4.0
+//geometry of the benchmarked hierarchy, the L1 associativity is swept
+#define BENCH_BLOCK 64
+#define BENCH_L1_SIZE 32768
+#define BENCH_VICTIM_SIZE 2048
+#define BENCH_L2_SIZE 262144
+#define BENCH_L2_ASSOC 16
+//blocks the streams draw from, 64MB of address space, larger than every cache
+#define BENCH_BLOCKS (1<<20)
+//skew of the Zipfian stream
+#define BENCH_ZIPF_S 0.99
+//one out of this many accesses is a write
+#define BENCH_WRITE_EVERY 4
+
+//the synthetic streams
+#define STREAM_SEQUENTIAL 0
+#define STREAM_STRIDED 1
+#define STREAM_RANDOM 2
+#define STREAM_ZIPF 3
+#define STREAM_CHASE 4
+#define BENCH_STREAMS 5
+static const char* stream_names[BENCH_STREAMS]={"sequential","strided","random","zipf","chase"};
+
+#define BENCH_POLICIES 8
+static const double policies[BENCH_POLICIES]={2,3,0.5,REPLACEMENT_TREE_PLRU,REPLACEMENT_BIT_PLRU,REPLACEMENT_SRRIP,REPLACEMENT_BRRIP,REPLACEMENT_DRRIP};
+static const char* policy_names[BENCH_POLICIES]={"LRU","LFU","LRFU","TPLRU","BPLRU","SRRIP","BRRIP","DRRIP"};
+
+#define BENCH_ASSOCS 4
+static const int assocs[BENCH_ASSOCS]={1,4,16,64};
+
+//every policy at every associativity, each without and with the victim cache and the L2
+#define BENCH_CONFIGS (BENCH_POLICIES*BENCH_ASSOCS*4)
+static inline int config_policy(int c){ return c/(BENCH_ASSOCS*4); }
+static inline int config_assoc(int c){ return (c/4)%BENCH_ASSOCS; }
+static inline int config_victim(int c){ return (c&1) ? BENCH_VICTIM_SIZE : 0; }
+static inline int config_l2(int c){ return (c&2) ? BENCH_L2_SIZE : 0; }
+
+//results of one configuration, also the format of a row of the CSV file
+struct bench_result{
+  char stream[16];
+  char policy[8];
+  int assoc;
+  int victim;
+  int l2;
+  double rate;
+  double ns;
+  long rss_kb;
+  long long misses;
+  //percentage of the accesses that hit in the L1
+  double hit_rate;
+  //difference between the fastest and the slowest run, as a fraction of the median
+  double spread;
+};
+
+
+//seconds of CPU time of this thread, so the time the thread spends switched out for other work on the machine is
+//not counted against the simulator
+static double now(){
+  struct timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&t);
+  return (double)t.tv_sec+(double)t.tv_nsec/1000000000.0;
+}
+
+
+
+//xorshift random numbers, the same sequence on every run
+static uint64_t next_random(uint64_t* state){
+  *state^=*state<<13;
+  *state^=*state>>7;
+  *state^=*state<<17;
+  return *state;
+}
+
+
+
+//resets the peak resident set size to the current one, returns 0 if the kernel does not support it
+static int reset_peak_rss(){
+  FILE* file=fopen("/proc/self/clear_refs","w");
+  if(file==NULL) return 0;
+  int ok=fputs("5",file)>=0;
+  if(fclose(file)!=0) ok=0;
+  return ok;
+}
+
+
+
+//peak resident set size in KB since the last reset, or of the whole process when it cannot be reset
+static long peak_rss(){
+  char LINE_IN[256];
+  long kb=-1;
+  FILE* file=fopen("/proc/self/status","r");
+  if(file!=NULL){
+    while(fgets(LINE_IN,256,file)!=NULL){
+      if(strncmp(LINE_IN,"VmHWM:",6)==0) kb=atol(LINE_IN+6);
+    }
+    fclose(file);
+  }
+  if(kb<0){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF,&usage);
+    kb=usage.ru_maxrss;
+  }
+  return kb;
+}
+
+
+
+//fill the stream with a mix of hot blocks, a larger working set and a sequential scan, used by -dispatch
+static void make_mixed_stream(unsigned long long* addresses, char* ops, size_t count){
+  uint64_t state=12345;
+  for(size_t i=0;i<count;i++){
+    next_random(&state);
+    uint64_t pick=state%100;
+    if(pick<50) addresses[i]=0x10000000ULL+((state>>8)%512)*64;
+    else if(pick<85) addresses[i]=0x20000000ULL+((state>>8)%16384)*64;
+    else addresses[i]=0x40000000ULL+(unsigned long long)i*32;
+    addresses[i]&=0xFFFFFFFFULL;
+    ops[i]=((state>>40)%4==0) ? 'w' : 'r';
+  }
+}
+
+
+
+//fill the stream with one of the synthetic patterns, every block is BENCH_BLOCK bytes
+static void make_stream(int kind, unsigned long long* addresses, char* ops, size_t count){
+  uint64_t state=0x2545F4914F6CDD1DULL;
+  const unsigned long long base=0x10000000ULL;
+  double* cdf=NULL;
+  uint32_t* next=NULL;
+  uint32_t block=0;
+  if(kind==STREAM_ZIPF){
+    //cumulative probability of every rank, rank r has weight 1/(r+1)^s
+    double sum=0;
+    cdf=(double*)malloc(BENCH_BLOCKS*sizeof(double));
+    for(int r=0;r<BENCH_BLOCKS;r++){
+      sum+=1.0/pow((double)(r+1),BENCH_ZIPF_S);
+      cdf[r]=sum;
+    }
+    for(int r=0;r<BENCH_BLOCKS;r++) cdf[r]/=sum;
+  }
+  if(kind==STREAM_CHASE){
+    //one random cycle through every block, so each step depends on the one before, like following a linked list
+    next=(uint32_t*)malloc(BENCH_BLOCKS*sizeof(uint32_t));
+    for(uint32_t i=0;i<BENCH_BLOCKS;i++) next[i]=i;
+    for(uint32_t i=BENCH_BLOCKS-1;i>0;i--){
+      uint32_t j=(uint32_t)(next_random(&state)%i);
+      uint32_t hold=next[i];
+      next[i]=next[j];
+      next[j]=hold;
+    }
+  }
+  for(size_t i=0;i<count;i++){
+    uint64_t random=next_random(&state);
+    switch(kind){
+    case STREAM_SEQUENTIAL:
+      //8 byte words one after another
+      addresses[i]=base+((unsigned long long)i*8)%((unsigned long long)BENCH_BLOCKS*BENCH_BLOCK);
+      break;
+    case STREAM_STRIDED:
+      //one block past a page each time, so consecutive accesses land in different sets
+      addresses[i]=base+((unsigned long long)i*(4096+BENCH_BLOCK))%((unsigned long long)BENCH_BLOCKS*BENCH_BLOCK);
+      break;
+    case STREAM_RANDOM:
+      addresses[i]=base+(random%BENCH_BLOCKS)*BENCH_BLOCK;
+      break;
+    case STREAM_ZIPF:{
+      //find the rank by binary search on the cdf, then scatter the ranks so the hot blocks do not share sets
+      double u=(double)(random>>11)*(1.0/9007199254740992.0);
+      int low=0,high=BENCH_BLOCKS-1;
+      while(low<high){
+	int mid=(low+high)/2;
+	if(cdf[mid]<u) low=mid+1;
+	else high=mid;
+      }
+      addresses[i]=base+(((uint64_t)low*2654435761ULL)%BENCH_BLOCKS)*BENCH_BLOCK;
+      break;
+    }
+    default:
+      block=next[block];
+      addresses[i]=base+(unsigned long long)block*BENCH_BLOCK;
+      break;
+    }
+    ops[i]=((random>>40)%BENCH_WRITE_EVERY==0) ? 'w' : 'r';
+  }
+  free(cdf);
+  free(next);
+}
+
+
+
+//time one hierarchy, built either at run time or specialized, and return its accesses per second
+static double run(int specialized, double replacement, int l1_assoc, int victim_size, int l2_size, const unsigned long long* addresses, const char* ops, size_t count, long long* misses, double* hit_rate){
+  Cache* L2;
+  Cache* victim=NULL;
+  Cache* L1;
+  Cache* second;
+  struct cache_stats l1,l2;
+  double start,seconds;
+  double replacement_L2=l2_replacement(replacement);
+  if(specialized){
+    L2=make_cache(BENCH_BLOCK,l2_size,BENCH_L2_ASSOC,replacement_L2,0,NULL,2,"L2",NULL);
+    second=l2_size>0 ? L2 : NULL;
+    if(victim_size>0) victim=make_cache(BENCH_BLOCK,victim_size,victim_size/BENCH_BLOCK,2,0,second,1,"Victim",NULL);
+    L1=make_cache(BENCH_BLOCK,BENCH_L1_SIZE,l1_assoc,replacement,0,second,1,"L1",victim);
+  }
+  else{
+    L2=new Cache(BENCH_BLOCK,l2_size,BENCH_L2_ASSOC,replacement_L2,0,NULL,2,"L2",NULL);
+    second=l2_size>0 ? L2 : NULL;
+    if(victim_size>0) victim=new Cache(BENCH_BLOCK,victim_size,victim_size/BENCH_BLOCK,2,0,second,1,"Victim",NULL);
+    L1=new Cache(BENCH_BLOCK,BENCH_L1_SIZE,l1_assoc,replacement,0,second,1,"L1",victim);
+  }
+  start=now();
+  for(size_t i=0;i<count;i++) L1->cache_in(addresses[i],ops[i]);
+  seconds=now()-start;
+  L1->stats(&l1);
+  L2->stats(&l2);
+  *misses=(long long)(l1.read_misses+l1.write_misses+l2.read_misses+l2.write_misses);
+  *hit_rate=100.0*(1.0-(double)(l1.read_misses+l1.write_misses)/(double)count);
+  delete L1;
+  if(victim!=NULL) delete victim;
+  delete L2;
+  return (double)count/seconds;
+}
+
+
+
+//the benchmark from before the suite, run time checks against make_cache on one mixed stream
+static int run_dispatch(size_t count){
+  unsigned long long* addresses=(unsigned long long*)malloc(count*sizeof(unsigned long long));
+  char* ops=(char*)malloc(count);
+  int victim_sizes[2]={0,BENCH_VICTIM_SIZE};
+  int failed=0;
+  make_mixed_stream(addresses,ops,count);
+  printf("===== Dispatch benchmark: %llu accesses, L1 32KB 8-way, L2 256KB 16-way, 64B blocks =====\n",(unsigned long long)count);
+  printf("%6s %8s %16s %16s %9s\n","POLICY","VICTIM","RUNTIME_ACC/S","SPECIAL_ACC/S","SPEEDUP");
+  for(int p=0;p<BENCH_POLICIES;p++){
+    for(int v=0;v<2;v++){
+      double best_runtime=0,best_special=0;
+      long long runtime_misses=0,special_misses=0;
+      double hit_rate;
+      for(int r=0;r<BENCH_REPEATS;r++){
+	double rate=run(0,policies[p],8,victim_sizes[v],BENCH_L2_SIZE,addresses,ops,count,&runtime_misses,&hit_rate);
+	if(rate>best_runtime) best_runtime=rate;
+	rate=run(1,policies[p],8,victim_sizes[v],BENCH_L2_SIZE,addresses,ops,count,&special_misses,&hit_rate);
+	if(rate>best_special) best_special=rate;
+      }
+      //both versions have to simulate the same thing
+      if(runtime_misses!=special_misses){
+	printf("%6s %8i results differ: %lli vs %lli misses\n",policy_names[p],victim_sizes[v],runtime_misses,special_misses);
+	failed=1;
+	continue;
+      }
+      printf("%6s %8i %16.0f %16.0f %8.2fx\n",policy_names[p],victim_sizes[v],best_runtime,best_special,best_special/best_runtime);
+    }
+  }
+  free(addresses);
+  free(ops);
+  return failed;
+}
+
+
+
+static int compare_doubles(const void* a, const void* b){
+  double x=*(const double*)a;
+  double y=*(const double*)b;
+  return (x>y)-(x<y);
+}
+
+
+
+//median of the values, which are sorted in place
+static double median(double* values, int num){
+  qsort(values,num,sizeof(double),compare_doubles);
+  return num%2==1 ? values[num/2] : (values[num/2-1]+values[num/2])/2;
+}
+
+
+
+//time one configuration of the suite repeats times, keeps the median rate and the spread of the runs in result
+static void time_config(double replacement, int l1_assoc, int victim_size, int l2_size, const unsigned long long* addresses, const char* ops, size_t count, int repeats, struct bench_result* result){
+  double* rates=(double*)malloc(repeats*sizeof(double));
+  for(int r=0;r<repeats;r++) rates[r]=run(1,replacement,l1_assoc,victim_size,l2_size,addresses,ops,count,&result->misses,&result->hit_rate);
+  result->rate=median(rates,repeats);
+  result->ns=1000000000.0/result->rate;
+  result->spread=(rates[repeats-1]-rates[0])/result->rate;
+  free(rates);
+}
+
+
+
+//read the results of an earlier run, returns how many there are, or -1 if the file cannot be read
+static int read_results(const char* path, struct bench_result** results){
+  char LINE_IN[512];
+  int num=0;
+  int max=64;
+  FILE* file=fopen(path,"r");
+  if(file==NULL) return -1;
+  *results=(struct bench_result*)malloc(max*sizeof(struct bench_result));
+  while(fgets(LINE_IN,512,file)!=NULL){
+    struct bench_result* r;
+    if(num==max){
+      max*=2;
+      *results=(struct bench_result*)realloc(*results,max*sizeof(struct bench_result));
+    }
+    r=&(*results)[num];
+    //the header line does not parse, so it is skipped, files from before the hit rate and spread columns still do
+    r->hit_rate=0;
+    r->spread=0;
+    if(sscanf(LINE_IN,"%15[^,],%7[^,],%i,%i,%i,%lf,%lf,%li,%lli,%lf,%lf",r->stream,r->policy,&r->assoc,&r->victim,&r->l2,
+	      &r->rate,&r->ns,&r->rss_kb,&r->misses,&r->hit_rate,&r->spread)>=9) num++;
+  }
+  fclose(file);
+  return num;
+}
+
+
+
+//same configuration of the baseline as a result, NULL if the baseline does not have it
+static const struct bench_result* find_baseline(const struct bench_result* result, const struct bench_result* baseline, int num_baseline){
+  for(int i=0;i<num_baseline;i++){
+    const struct bench_result* b=&baseline[i];
+    if(strcmp(b->stream,result->stream)==0 && strcmp(b->policy,result->policy)==0 && b->assoc==result->assoc
+       && b->victim==result->victim && b->l2==result->l2) return b;
+  }
+  return NULL;
+}
+
+
+
+//checks the misses of a result against the baseline, returns 1 if they changed
+static int compare_misses(const struct bench_result* result, const struct bench_result* b){
+  if(b->misses==result->misses) return 0;
+  printf("  REGRESSION %s %s %i-way victim %i l2 %i: %lli misses, the baseline had %lli\n",result->stream,result->policy,
+	 result->assoc,result->victim,result->l2,result->misses,b->misses);
+  return 1;
+}
+
+
+
+//how much two runs differ in speed, from the log of the ratio of the rates of every result that has the misses of
+//the baseline. center is the median of the logs and noise their median absolute deviation, scaled to match a
+//standard deviation. Returns 0 if no result can be compared
+static int speed_noise(const struct bench_result* results, int num_results, const struct bench_result* baseline, int num_baseline, double* center, double* noise){
+  double* logs=(double*)malloc(num_results*sizeof(double));
+  int num=0;
+  for(int i=0;i<num_results;i++){
+    const struct bench_result* b=find_baseline(&results[i],baseline,num_baseline);
+    if(b!=NULL && b->misses==results[i].misses && b->rate>0) logs[num++]=log(results[i].rate/b->rate);
+  }
+  if(num>0){
+    *center=median(logs,num);
+    for(int i=0;i<num;i++) logs[i]=fabs(logs[i]-*center);
+    *noise=1.4826*median(logs,num);
+  }
+  free(logs);
+  return num>0;
+}
+
+
+
+//slowdown a result that has the misses of the baseline is allowed before it regressed, 0 if it cannot be compared
+static double allowed_slowdown(const struct bench_result* result, const struct bench_result* b, double tolerance, double noise){
+  double allowed=1.0-exp(-BENCH_NOISE*noise);
+  if(b==NULL || b->misses!=result->misses || b->rate<=0) return 0;
+  return allowed>tolerance ? allowed : tolerance;
+}
+
+
+
+int main(int argc, char** argv){
+  size_t count=1000000;
+  int repeats=BENCH_REPEATS;
+  double tolerance=BENCH_TOLERANCE;
+  const char* csv_path=NULL;
+  const char* compare_path=NULL;
+  struct bench_result* baseline=NULL;
+  int num_baseline=0;
+  int dispatch=0;
+  int regressions=0;
+  int rss_exact;
+  double center,noise;
+  FILE* csv=NULL;
+  for(int i=1;i<argc;i++){
+    if(strcmp(argv[i],"-repeats")==0 && i+1<argc) repeats=atoi(argv[++i]);
+    else if(strcmp(argv[i],"-csv")==0 && i+1<argc) csv_path=argv[++i];
+    else if(strcmp(argv[i],"-compare")==0 && i+1<argc) compare_path=argv[++i];
+    else if(strcmp(argv[i],"-tolerance")==0 && i+1<argc) tolerance=atof(argv[++i]);
+    else if(strcmp(argv[i],"-dispatch")==0) dispatch=1;
+    else count=strtoull(argv[i],NULL,10);
+  }
+  if(count==0 || repeats<1){
+    printf("usage: %s [accesses] [-repeats N] [-csv FILE] [-compare FILE] [-tolerance FRACTION] [-dispatch]\n",argv[0]);
+    return 1;
+  }
+  if(dispatch) return run_dispatch(count);
+  if(compare_path!=NULL){
+    num_baseline=read_results(compare_path,&baseline);
+    if(num_baseline<0){
+      printf("Error opening baseline %s\n",compare_path);
+      return 1;
+    }
+  }
+  if(csv_path!=NULL){
+    csv=fopen(csv_path,"w");
+    if(csv==NULL){
+      printf("Error opening %s\n",csv_path);
+      return 1;
+    }
+    fprintf(csv,"stream,policy,assoc,victim,l2,accesses_per_sec,ns_per_access,peak_rss_kb,misses,hit_rate,spread\n");
+  }
+
+  unsigned long long* addresses=(unsigned long long*)malloc(count*sizeof(unsigned long long));
+  char* ops=(char*)malloc(count);
+  struct bench_result* results=(struct bench_result*)malloc(BENCH_STREAMS*BENCH_CONFIGS*sizeof(struct bench_result));
+  rss_exact=reset_peak_rss();
+  printf("===== Simulator benchmark: %llu accesses per run, median of %i, L1 32KB, victim 2KB, L2 256KB 16-way, 64B blocks =====\n",
+	 (unsigned long long)count,repeats);
+  if(!rss_exact) printf("the peak RSS cannot be reset on this system, it is the peak of the whole process\n");
+  printf("%10s %6s %5s %6s %3s %14s %8s %12s %12s %7s\n","STREAM","POLICY","ASSOC","VICTIM","L2","ACC/S","NS/ACC","PEAK_RSS_KB","MISSES","L1_HIT%");
+  for(int s=0;s<BENCH_STREAMS;s++){
+    make_stream(s,addresses,ops,count);
+    for(int c=0;c<BENCH_CONFIGS;c++){
+      struct bench_result* result=&results[s*BENCH_CONFIGS+c];
+      const struct bench_result* b;
+      reset_peak_rss();
+      time_config(policies[config_policy(c)],assocs[config_assoc(c)],config_victim(c),config_l2(c),addresses,ops,count,repeats,result);
+      snprintf(result->stream,sizeof(result->stream),"%s",stream_names[s]);
+      snprintf(result->policy,sizeof(result->policy),"%s",policy_names[config_policy(c)]);
+      result->assoc=assocs[config_assoc(c)];
+      result->victim=config_victim(c);
+      result->l2=config_l2(c);
+      result->rss_kb=peak_rss();
+      printf("%10s %6s %5i %6i %3s %14.0f %8.2f %12li %12lli %7.2f\n",result->stream,result->policy,result->assoc,
+	     result->victim,result->l2>0 ? "yes" : "no",result->rate,result->ns,result->rss_kb,result->misses,result->hit_rate);
+      if(csv!=NULL){
+	fprintf(csv,"%s,%s,%i,%i,%i,%.0f,%.3f,%li,%lli,%.4f,%.4f\n",result->stream,result->policy,result->assoc,result->victim,
+		result->l2,result->rate,result->ns,result->rss_kb,result->misses,result->hit_rate,result->spread);
+      }
+      b=baseline!=NULL ? find_baseline(result,baseline,num_baseline) : NULL;
+      if(b!=NULL) regressions+=compare_misses(result,b);
+    }
+  }
+  //a configuration that looks slower than the noise allows is timed again with twice the runs, once every other one
+  //is done, so a slow spell of the machine does not cover both, and the faster of the two counts
+  if(baseline!=NULL && speed_noise(results,BENCH_STREAMS*BENCH_CONFIGS,baseline,num_baseline,&center,&noise)){
+    int stream=-1;
+    printf("\nthe median configuration runs at %.1f%% of the baseline, the rates of two runs differ by %.1f%%\n",
+	   100.0*exp(center),100.0*(exp(noise)-1.0));
+    for(int i=0;i<BENCH_STREAMS*BENCH_CONFIGS;i++){
+      struct bench_result* result=&results[i];
+      struct bench_result again=*result;
+      const struct bench_result* b=find_baseline(result,baseline,num_baseline);
+      double allowed=allowed_slowdown(result,b,tolerance,noise);
+      int c=i%BENCH_CONFIGS;
+      if(allowed==0 || result->rate>=b->rate*(1.0-allowed)) continue;
+      if(stream!=i/BENCH_CONFIGS){
+	stream=i/BENCH_CONFIGS;
+	make_stream(stream,addresses,ops,count);
+      }
+      time_config(policies[config_policy(c)],assocs[config_assoc(c)],config_victim(c),config_l2(c),addresses,ops,count,2*repeats,&again);
+      if(again.rate>result->rate) result->rate=again.rate;
+      if(result->rate<b->rate*(1.0-allowed)){
+	printf("  REGRESSION %s %s %i-way victim %i l2 %i: %.0f acc/s, %.1f%% slower than the baseline, %.1f%% allowed\n",
+	       result->stream,result->policy,result->assoc,result->victim,result->l2,result->rate,100.0*(1.0-result->rate/b->rate),
+	       100.0*allowed);
+	regressions++;
+      }
+    }
+    if(exp(center)<1.0-tolerance){
+      printf("  REGRESSION overall: the median configuration is %.1f%% slower than the baseline\n",100.0*(1.0-exp(center)));
+      regressions++;
+    }
+  }
+  if(csv!=NULL) fclose(csv);
+  if(baseline!=NULL){
+    if(regressions>0) printf("\n%i configurations regressed against %s\n",regressions,compare_path);
+    else printf("\nno regressions against %s\n",compare_path);
+  }
+  free(baseline);
+  free(results);
+  free(addresses);
+  free(ops);
+  return regressions>0;
+}
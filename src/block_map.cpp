@@ -0,0 +1,117 @@
+/**************************************************************************************************************************
+
+Filename: block_map.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the block map declared in block_map.h.
+The table is kept at most half full, and it doubles in size when it would go past that. Its arrays come from
+arena.h, so the tables of large caches are on huge pages.
+
+****************************************************************************************************************************/
+
+#include "block_map.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+BlockMap::BlockMap(size_t expected){
+  size_t num_slots=16;
+  shift=60;
+  //keep the table at most half full
+  while(num_slots<2*expected){
+    num_slots*=2;
+    shift--;
+  }
+  mask=num_slots-1;
+  count=0;
+  keys=(uint64_t*)arena_alloc(num_slots*sizeof(uint64_t));
+  values=(uint64_t*)arena_alloc(num_slots*sizeof(uint64_t));
+  memset(keys,0xFF,num_slots*sizeof(uint64_t));
+}
+
+
+
+BlockMap::~BlockMap(){
+  arena_free(keys,(mask+1)*sizeof(uint64_t));
+  arena_free(values,(mask+1)*sizeof(uint64_t));
+}
+
+
+
+//double the table and put every entry back in
+void BlockMap::grow(){
+  uint64_t* old_keys=keys;
+  uint64_t* old_values=values;
+  size_t old_slots=mask+1;
+  size_t num_slots=old_slots*2;
+  mask=num_slots-1;
+  shift--;
+  keys=(uint64_t*)arena_alloc(num_slots*sizeof(uint64_t));
+  values=(uint64_t*)arena_alloc(num_slots*sizeof(uint64_t));
+  memset(keys,0xFF,num_slots*sizeof(uint64_t));
+  for(size_t j=0;j<old_slots;j++){
+    if(old_keys[j]==BLOCK_MAP_EMPTY) continue;
+    size_t i=hash(old_keys[j]);
+    while(keys[i]!=BLOCK_MAP_EMPTY) i=(i+1)&mask;
+    keys[i]=old_keys[j];
+    values[i]=old_values[j];
+  }
+  arena_free(old_keys,old_slots*sizeof(uint64_t));
+  arena_free(old_values,old_slots*sizeof(uint64_t));
+}
+
+
+
+uint64_t* BlockMap::insert(uint64_t key, uint64_t value){
+  size_t i;
+  if(2*(count+1)>mask+1) grow();
+  i=hash(key);
+  while(keys[i]!=BLOCK_MAP_EMPTY){
+    if(keys[i]==key){
+      values[i]=value;
+      return &values[i];
+    }
+    i=(i+1)&mask;
+  }
+  keys[i]=key;
+  values[i]=value;
+  count++;
+  return &values[i];
+}
+
+
+
+//remove the key, and shift back any entries that probed past it
+void BlockMap::erase(uint64_t key){
+  size_t i=hash(key);
+  size_t j;
+  while(keys[i]!=key){
+    if(keys[i]==BLOCK_MAP_EMPTY) return;
+    i=(i+1)&mask;
+  }
+  keys[i]=BLOCK_MAP_EMPTY;
+  count--;
+  j=i;
+  for(;;){
+    j=(j+1)&mask;
+    if(keys[j]==BLOCK_MAP_EMPTY) return;
+    size_t home=hash(keys[j]);
+    //the entry at j can move to the hole at i if its home slot is not between i and j
+    if((i<=j) ? (home>i && home<=j) : (home>i || home<=j)) continue;
+    keys[i]=keys[j];
+    values[i]=values[j];
+    keys[j]=BLOCK_MAP_EMPTY;
+    i=j;
+  }
+}
+
+
+
+void BlockMap::clear(){
+  memset(keys,0xFF,(mask+1)*sizeof(uint64_t));
+  count=0;
+}
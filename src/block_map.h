@@ -0,0 +1,67 @@
+/**************************************************************************************************************
+
+Filename:     block_map.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the block map class. A block map is a hash table that maps
+a 64 bit block address to a 64 bit value. It uses open addressing with linear probing, so a lookup touches
+one or two cache lines of the host, and deletes shift the following entries back so no tombstones are left.
+It is used anywhere the simulator needs to find a block without scanning, such as the last access time of
+every block in the stack distance engine. The lookup is in the header so it can be inlined in the hot loops.
+
+*****************************************************************************************************************/
+#ifndef BLOCK_MAP_H
+#define BLOCK_MAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//key used to mark an empty slot, block addresses never have every bit set
+#define BLOCK_MAP_EMPTY 0xFFFFFFFFFFFFFFFFULL
+
+//Class that maps block addresses to values
+class BlockMap{
+ private:
+  uint64_t* keys;
+  uint64_t* values;
+  size_t mask;
+  size_t count;
+  int shift;
+  //doubles the number of slots
+  void grow();
+ public:
+  BlockMap(size_t expected);
+  ~BlockMap();
+  //slot the key hashes to
+  inline size_t hash(uint64_t key){ return (size_t)((key*0x9E3779B97F4A7C15ULL)>>shift); }
+  //returns a pointer to the value of key, or NULL if the key is not in the map
+  inline uint64_t* find(uint64_t key){
+    size_t i=hash(key);
+    while(keys[i]!=BLOCK_MAP_EMPTY){
+      if(keys[i]==key) return &values[i];
+      i=(i+1)&mask;
+    }
+    return NULL;
+  }
+  //starts loading the slot key hashes to, for a find that comes a little later
+  inline void prefetch(uint64_t key){ size_t i=hash(key); __builtin_prefetch(&keys[i]); __builtin_prefetch(&values[i]); }
+  //sets the value of key, adding the key if needed, and returns a pointer to the value
+  uint64_t* insert(uint64_t key, uint64_t value);
+  //removes the key if it is in the map
+  void erase(uint64_t key);
+  //removes every key
+  void clear();
+  size_t size(){ return count; }
+  //used to walk every entry, a slot is in use if its key is not BLOCK_MAP_EMPTY
+  size_t slots(){ return mask+1; }
+  uint64_t key_at(size_t i){ return keys[i]; }
+  uint64_t value_at(size_t i){ return values[i]; }
+};
+
+#endif
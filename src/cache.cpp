@@ -7,7 +7,8 @@ Date modified: 10/1/17
 Author Kevin Volkel
 
 Description: This file contains all of the implementations for the functions declared in the cache.h file.
-The cache model supports 3 different replacement policies right now, LRU and LFU, and LRFU.
+The cache model supports 8 different replacement policies right now, LRU, LFU, LRFU, tree and bit pseudo-LRU,
+and the SRRIP, BRRIP and DRRIP policies of Jaleel et al., with DRRIP picking between the other two by set dueling.
 The cache model supports 2 different write policies WBWA, and WTNA, though for part B we only use WBWA.
 When a cache needs to make a read or write to the next level, the cache_in function for the next lowest level is called with
 a wrapper function that passes the appropriate address and the appropriate read/write command.
@@ -22,15 +23,86 @@ The newest version for part B also supports simulation of a vicitm cache and sup
 ****************************************************************************************************************************/
 
 #include "cache.h"
+#include "classify.h"
+#include "arena.h"
 #include <stdint.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+//alignment of every array in the cache storage, one host cache line
+#define CACHE_ALIGN 64
+
+//bytes of tags compared by one SIMD instruction
+#ifdef __AVX2__
+#define CACHE_SIMD_BYTES 32
+#else
+#define CACHE_SIMD_BYTES 16
+#endif
+
+
+//round an offset in the cache storage up to the next aligned one
+static inline size_t align_up(size_t offset){
+  return (offset+CACHE_ALIGN-1)&~(size_t)(CACHE_ALIGN-1);
+}
+
+//names of the replacement arguments, in the order of the policies
+static const char* replacement_names[REPLACE_POLICIES]={"lru","lfu",NULL,"tree_plru","bit_plru","srrip","brrip","drrip"};
+static const double replacement_values[REPLACE_POLICIES]={2,3,0,REPLACEMENT_TREE_PLRU,REPLACEMENT_BIT_PLRU,
+							   REPLACEMENT_SRRIP,REPLACEMENT_BRRIP,REPLACEMENT_DRRIP};
+
+double replacement_of(const char* arg){
+  for(int p=0;p<REPLACE_POLICIES;p++){
+    if(replacement_names[p]!=NULL && strcasecmp(arg,replacement_names[p])==0) return replacement_values[p];
+  }
+  return atof(arg);
+}
+
+
+
+//map the replacement argument to a replacement policy, 2 is LRU, 3 is LFU, the negative REPLACEMENT values are the
+//pseudo-LRU and RRIP policies, and anything else is the lambda of LRFU
+int replace_policy_of(double rep_policy){
+  if(rep_policy==2) return REPLACE_LRU;
+  else if(rep_policy==3) return REPLACE_LFU;
+  else if(rep_policy==REPLACEMENT_TREE_PLRU) return REPLACE_TREE_PLRU;
+  else if(rep_policy==REPLACEMENT_BIT_PLRU) return REPLACE_BIT_PLRU;
+  else if(rep_policy==REPLACEMENT_SRRIP) return REPLACE_SRRIP;
+  else if(rep_policy==REPLACEMENT_BRRIP) return REPLACE_BRRIP;
+  else if(rep_policy==REPLACEMENT_DRRIP) return REPLACE_DRRIP;
+  return REPLACE_LRFU;
+}
+
+
+
+const char* replacement_arg_name(int policy){
+  return replacement_names[policy];
+}
+
+
+
+//the L2 keeps the policy of the L1, except for LRFU, where it uses LRU like the original simulator
+double l2_replacement(double rep_policy){
+  if(replace_policy_of(rep_policy)==REPLACE_LRFU) return 2;
+  return rep_policy;
+}
+
+
+
+const char* replace_policy_name(int policy){
+  static const char* names[REPLACE_POLICIES]={"LRU","LFU","LRFU","tree PLRU","bit PLRU","SRRIP","BRRIP","DRRIP"};
+  return names[policy];
+}
+
 
 
 //initiate the cache with input parameters
-Cache::Cache(int blocksize, int size, int ass,double rep_polic, int wr_policy, Cache* next_cache, int level, char* name,Cache* victim_c){
+Cache::Cache(int blocksize, int size, int ass,double rep_polic, int wr_policy, Cache* next_cache, int level, const char* name,Cache* victim_c, int addr_bits, int shards){
   //initiate stats                                                                                                                    
   num_reads=0;
   num_writes=0;
@@ -38,48 +110,151 @@ Cache::Cache(int blocksize, int size, int ass,double rep_polic, int wr_policy, C
   write_miss=0;
   write_backs=0;
   miss_rate=0;
+  mem_traffic=0;
+  average_time=0;
   swap=0;
   swaps=0;
+  warm_block=0;
+  warm_set=0;
+  warm_way=-1;
   //counter for LRFU counts all reads and writes
   global_counter=0;
+  cache_name=name;
+  //victim caches do not fetch from the next level on a miss
+  is_victim=(strcmp(name,"Victim")==0);
+  num_sets=0;
+  storage=NULL;
+  storage_size=0;
+  ages=NULL;
+  CRF=NULL;
+  last_time_stamp=NULL;
+  set_counters=NULL;
+  decay_table=NULL;
+  lrfu_key=NULL;
+  fa_index=NULL;
+  lru_prev=NULL;
+  plru_bits=NULL;
+  rrip_low=NULL;
+  rrip_high=NULL;
+  rrip_psel=(1<<RRIP_PSEL_BITS)/2-1;
+  rrip_stride=0;
+  rrip_bimodal=0;
+  classifier=NULL;
   //only set things if this instance of cache is enabled
   if(size>0){
     //load in cache parameters
-    cache_name=name;
     blk_per_set=ass;
-    num_sets=(size/(blocksize*ass));
+    num_sets=(size/(blocksize*ass))/shards;
     block_size=blocksize;
     assoc=ass;
     write_policy=wr_policy;
     //set for the appropriate replacment policy
-    if(rep_polic==2){
-      replace_policy=0;
-    }
-    else if(rep_polic==3){
-      replace_policy=1;
-    }
-    else replace_policy=2;
+    replace_policy=replace_policy_of(rep_polic);
     //set the lambda variable for LRFU
     lambda=rep_polic;
     //calculate number of bits for each field
     set_bits=(int)log2(num_sets);
     block_bits=(int)log2(block_size);
-    tag_bits=32-(set_bits+block_bits);
+    //the shard bits are not part of the addresses a shard is given
+    address_bits=addr_bits-(int)log2(shards);
+    address_mask=address_bits>=64 ? ~0ULL : (1ULL<<address_bits)-1;
+    tag_bits=address_bits-(set_bits+block_bits);
+    //tags only need to be as wide as the tag field
+    tag_bytes=tag_bits<=32 ? 4 : 8;
+    simd_ways=CACHE_SIMD_BYTES/tag_bytes;
+    //round the tags of a set up to a full SIMD register so every set starts aligned
+    if(assoc>=simd_ways) tag_stride=(assoc+simd_ways-1)/simd_ways*simd_ways;
+    else tag_stride=assoc;
+    mask_words=(assoc+63)/64;
+    //the pseudo-LRU tree spans the associativity rounded up to a power of 2
+    plru_levels=0;
+    while((1<<plru_levels)<assoc) plru_levels++;
+    plru_words=((1<<plru_levels)+63)/64;
     //initiate the cache, and set counters used in replacement policies
-    set_array=(struct block**)malloc(num_sets*sizeof(struct block*));
-    set_counters=(uint32_t*)malloc(num_sets*sizeof(uint32_t));
-    for(int i=0; i<num_sets;i++){
-      set_array[i]=(struct block*)malloc(blk_per_set*sizeof(struct block));
-      for(int j=0;j<blk_per_set;j++){
-	set_array[i][j].valid=0;
-	set_array[i][j].dirty=0;
-	set_array[i][j].age=0;
-	set_array[i][j].print_LRU=0;
-	set_array[i][j].last_time_stamp=0;
-	set_array[i][j].CRF=0;
-      }
-      set_counters[i]=0;
+    //every array is carved out of one allocation, and all of them start out zeroed so every block is invalid
+    size_t blocks=(size_t)num_sets*tag_stride;
+    size_t masks=(size_t)num_sets*mask_words;
+    //only the metadata of the policy in use takes any room
+    size_t lfu_blocks=replace_policy==REPLACE_LFU ? blocks : 0;
+    size_t lfu_sets=replace_policy==REPLACE_LFU ? (size_t)num_sets : 0;
+    size_t lrfu_blocks=replace_policy==REPLACE_LRFU ? blocks : 0;
+    size_t ordered_blocks=(replace_policy==REPLACE_LRFU && lrfu_orders_sets()) ? blocks : 0;
+    size_t ordered_sets=ordered_blocks>0 ? (size_t)num_sets : 0;
+    size_t lru_blocks=replace_policy==REPLACE_LRU ? blocks : 0;
+    size_t lru_sets=replace_policy==REPLACE_LRU ? (size_t)num_sets : 0;
+    size_t plru_size=(replace_policy==REPLACE_TREE_PLRU || replace_policy==REPLACE_BIT_PLRU) ? (size_t)num_sets*plru_words : 0;
+    size_t rrip_size=replace_policy>=REPLACE_SRRIP ? masks : 0;
+    size_t offset=0;
+    size_t tags_at=offset; offset=align_up(offset+blocks*tag_bytes);
+    size_t valid_at=offset; offset=align_up(offset+masks*sizeof(uint64_t));
+    size_t dirty_at=offset; offset=align_up(offset+masks*sizeof(uint64_t));
+    size_t ages_at=offset; offset=align_up(offset+lfu_blocks*sizeof(int));
+    size_t counters_at=offset; offset=align_up(offset+lfu_sets*sizeof(uint32_t));
+    size_t CRF_at=offset; offset=align_up(offset+lrfu_blocks*sizeof(double));
+    size_t stamp_at=offset; offset=align_up(offset+lrfu_blocks*sizeof(int64_t));
+    size_t key_at=offset; offset=align_up(offset+ordered_blocks*sizeof(double));
+    size_t pos_at=offset; offset=align_up(offset+ordered_blocks*sizeof(uint16_t));
+    size_t lrfu_prev_at=offset; offset=align_up(offset+ordered_blocks*sizeof(uint16_t));
+    size_t lrfu_next_at=offset; offset=align_up(offset+ordered_blocks*sizeof(uint16_t));
+    size_t heap_at=offset; offset=align_up(offset+ordered_sets*assoc*sizeof(uint16_t));
+    size_t heap_size_at=offset; offset=align_up(offset+ordered_sets*sizeof(uint16_t));
+    size_t lrfu_head_at=offset; offset=align_up(offset+ordered_sets*sizeof(uint16_t));
+    size_t lrfu_tail_at=offset; offset=align_up(offset+ordered_sets*sizeof(uint16_t));
+    size_t zero_at=offset; offset=align_up(offset+(ordered_sets>0 ? masks : 0)*sizeof(uint64_t));
+    size_t stack_at=offset; offset=align_up(offset+(ordered_sets>0 ? (size_t)assoc : 0)*sizeof(uint16_t));
+    size_t prev_at=offset; offset=align_up(offset+lru_blocks*sizeof(uint32_t));
+    size_t next_at=offset; offset=align_up(offset+lru_blocks*sizeof(uint32_t));
+    size_t head_at=offset; offset=align_up(offset+lru_sets*sizeof(uint32_t));
+    size_t tail_at=offset; offset=align_up(offset+lru_sets*sizeof(uint32_t));
+    size_t plru_at=offset; offset=align_up(offset+plru_size*sizeof(uint64_t));
+    size_t low_at=offset; offset=align_up(offset+rrip_size*sizeof(uint64_t));
+    size_t high_at=offset; offset=align_up(offset+rrip_size*sizeof(uint64_t));
+    storage_size=offset;
+    storage=arena_alloc(offset);
+    tags=(char*)storage+tags_at;
+    valid_bits=(uint64_t*)((char*)storage+valid_at);
+    dirty_bits=(uint64_t*)((char*)storage+dirty_at);
+    if(lfu_blocks>0){
+      ages=(int*)((char*)storage+ages_at);
+      set_counters=(uint32_t*)((char*)storage+counters_at);
+    }
+    if(lrfu_blocks>0){
+      CRF=(double*)((char*)storage+CRF_at);
+      last_time_stamp=(int64_t*)((char*)storage+stamp_at);
     }
+    if(ordered_blocks>0){
+      lrfu_key=(double*)((char*)storage+key_at);
+      lrfu_pos=(uint16_t*)((char*)storage+pos_at);
+      lrfu_prev=(uint16_t*)((char*)storage+lrfu_prev_at);
+      lrfu_next=(uint16_t*)((char*)storage+lrfu_next_at);
+      lrfu_heap=(uint16_t*)((char*)storage+heap_at);
+      lrfu_heap_size=(uint16_t*)((char*)storage+heap_size_at);
+      lrfu_head=(uint16_t*)((char*)storage+lrfu_head_at);
+      lrfu_tail=(uint16_t*)((char*)storage+lrfu_tail_at);
+      lrfu_zero=(uint64_t*)((char*)storage+zero_at);
+      lrfu_stack=(uint16_t*)((char*)storage+stack_at);
+    }
+    //every recency list starts out empty
+    if(lru_blocks>0){
+      lru_prev=(uint32_t*)((char*)storage+prev_at);
+      lru_next=(uint32_t*)((char*)storage+next_at);
+      lru_head=(uint32_t*)((char*)storage+head_at);
+      lru_tail=(uint32_t*)((char*)storage+tail_at);
+      memset(lru_head,0xFF,lru_sets*sizeof(uint32_t));
+      memset(lru_tail,0xFF,lru_sets*sizeof(uint32_t));
+    }
+    if(plru_size>0) plru_bits=(uint64_t*)((char*)storage+plru_at);
+    if(rrip_size>0){
+      rrip_low=(uint64_t*)((char*)storage+low_at);
+      rrip_high=(uint64_t*)((char*)storage+high_at);
+      //up to RRIP_LEADERS leader sets for each policy, spread evenly, a cache with one set cannot duel and follows SRRIP
+      int leaders=num_sets/2<RRIP_LEADERS ? num_sets/2 : RRIP_LEADERS;
+      rrip_stride=leaders>0 ? num_sets/leaders : 0;
+    }
+    //large fully associative caches, like the victim cache, get an index from tag to way
+    if(num_sets==1 && assoc>=FA_INDEX_WAYS) fa_index=new BlockMap(assoc);
+    //build the LRFU decay table and the ordered sets
+    if(replace_policy==REPLACE_LRFU) lrfu_init();
     //initiate the next level
     next_level=next_cache;
     //set victim cache
@@ -97,27 +272,72 @@ Cache::Cache(int blocksize, int size, int ass,double rep_polic, int wr_policy, C
   }
 }
 
+//free the sets of the cache if it was enabled
+Cache::~Cache(){
+  arena_free(storage,storage_size);
+  lrfu_free();
+  if(fa_index!=NULL) delete fa_index;
+  if(classifier!=NULL) delete classifier;
+}
+
 //function to read in a address and write/read command. figures out what to do with the request
+//this is the run time dispatched version, the policies are read from the cache on every access
 void Cache::cache_in(unsigned long long address, char r_or_w){
-  int tag;
+  access<POLICY_DYNAMIC,POLICY_DYNAMIC,POLICY_DYNAMIC>(address,r_or_w);
+}
+
+
+
+void Cache::cache_in_batch(const unsigned long long* addresses, const char* ops, size_t count){
+  access_batch<POLICY_DYNAMIC,POLICY_DYNAMIC,POLICY_DYNAMIC>(addresses,ops,count);
+}
+
+
+
+void Cache::cache_warm(unsigned long long address, char r_or_w){
+  warm<POLICY_DYNAMIC,POLICY_DYNAMIC,POLICY_DYNAMIC>(address,r_or_w);
+}
+
+
+
+template<int REP, int WR, int VIC>
+void Cache::access_batch(const unsigned long long* addresses, const char* ops, size_t count){
+  for(size_t i=0;i<count;i++){
+    if(i+CACHE_PREFETCH<count) prefetch(addresses[i+CACHE_PREFETCH]);
+    access<REP,WR,VIC>(addresses[i],ops[i]);
+  }
+}
+
+
+
+//the body of cache_in. The template arguments are the replacement policy, write policy and victim role of the cache,
+//when they are known at compile time every policy check below is folded away
+template<int REP, int WR, int VIC>
+void Cache::access(unsigned long long address, char r_or_w){
+  const int wr=(WR==POLICY_DYNAMIC) ? write_policy : WR;
+  uint64_t tag;
   int set;
   int index_of_hit;
   int vh_index=-1;
-  int block_tag=block_bits+tag_bits;
   unsigned long long victim_address;
   //set swap initially to 0
   swap=0;
+  //a hit here can move the block of the last warm-up hit
+  warm_way=-1;
   //increment the number of reads or number of writes variables
   read_or_write=r_or_w;
   if(r_or_w=='r') num_reads++;
   else num_writes++;
   //find the tag and set
-  tag=((address)>>(set_bits+block_bits));
-  set=((address<<tag_bits)&0x00000000FFFFFFFF)>>(block_tag);
-  //if theres a victim cache look in it
-  if(victim!=NULL) vh_index=victim->hit_or_miss(address>>block_bits,0);
+  address&=address_mask;
+  tag=address>>(set_bits+block_bits);
+  set=(int)((address>>block_bits)&((1ULL<<set_bits)-1));
   //look in the cache for the tag
   index_of_hit=hit_or_miss(tag, set);
+  //if theres a victim cache look in it, a block is never in both so there is no need to on a hit
+  if(victim!=NULL && index_of_hit==-1) vh_index=victim->hit_or_miss(address>>block_bits,0);
+  //a hit in the victim cache is not a miss of this level
+  if(classifier!=NULL) classifier->record(address,set,index_of_hit==-1 && vh_index==-1);
   //increment the global counter
   global_counter++;
   if(vh_index==-1 || victim==NULL){ 
@@ -126,23 +346,19 @@ void Cache::cache_in(unsigned long long address, char r_or_w){
       //hit on a read
       if(r_or_w=='r'){
 	//update counters for the cache depending on replacement policy
-	if(replace_policy==0) LRU_update(tag, set, index_of_hit);
-	else if(replace_policy==1) LFU_update(tag,set,index_of_hit);
-	else LRFU_update(tag,set,index_of_hit);
+	update<REP>(tag,set,index_of_hit);
       }
       
       //hit on a write
       else{
 	//if WBWA dirty the block that was written to 
-	if(write_policy==0) set_array[set][index_of_hit].dirty=1;
+	if(wr==WRITE_WBWA) set_dirty(set,index_of_hit,1);
 	else{
 	  //issue write to next level for WTNA
 	  issue_to_next(address,'w');
 	}
 	//on either write policy, update counters for the replacement policies
-	if(replace_policy==0)LRU_update(tag,set,index_of_hit);
-	else if(replace_policy==1) LFU_update(tag,set,index_of_hit);
-	else LRFU_update(tag,set,index_of_hit);
+	update<REP>(tag,set,index_of_hit);
       }
     }
     //we have a miss
@@ -151,18 +367,14 @@ void Cache::cache_in(unsigned long long address, char r_or_w){
       if(r_or_w=='r'){
 	//increment read_miss counter and call the appropriate replacement policy replace function
 	read_miss++;
-	if(replace_policy==0) LRU_replace(tag,set, address,0);
-	else if(replace_policy==1) LFU_replace(tag,set,address,0);
-	else LRFU_replace(tag,set,address,0);
+	replace<REP,VIC>(tag,set,address,0);
       }
       else{
 	//write miss, increment write miss counter
 	write_miss++;
-	if(write_policy==0){
+	if(wr==WRITE_WBWA){
 	  //only replace a block on a WBWA write policy
-	  if(replace_policy==0) LRU_replace(tag,set,address,0);
-	  else if(replace_policy==1) LFU_replace(tag,set,address,0);
-	  else LRFU_replace(tag,set,address,0);
+	  replace<REP,VIC>(tag,set,address,0);
 	}
 	else{
 	  //issue write to next level and do not replace a block (WTNA)
@@ -180,9 +392,7 @@ void Cache::cache_in(unsigned long long address, char r_or_w){
     swaps++;
     victim->LRU_update(address>>block_bits,0, vh_index);
     swap=1;
-    if(replace_policy==0)LRU_replace(tag,set,address,vh_index);
-    else if(replace_policy==1) LFU_replace(tag,set,address,vh_index);
-    else LRFU_replace(tag,set,address,vh_index);
+    replace<REP,VIC>(tag,set,address,vh_index);
     swap=0;
   }
 }
@@ -190,96 +400,178 @@ void Cache::cache_in(unsigned long long address, char r_or_w){
 
 
 
-//function for updating on the LRU policy
-void Cache::LRU_update(int tag, int set, int hit){
-  int old_age=set_array[set][hit].age;
-  update_Print_LRU(tag,set,hit);
-  set_array[set][hit].age=0;
-  //update the block counters who are valid and less than the old counter of the accessed block
-  for(int i=0;i<blk_per_set;i++){
-    if(set_array[set][i].age<old_age && set_array[set][i].valid==1 && i!=hit) set_array[set][i].age++;
+//the body of cache_warm. It goes through the same lookups and calls the same update and replace functions as access,
+//in the same order, so the caches end up in the same state, but a hit returns straight away and nothing is counted.
+//The replace functions still count the write backs, which clear_stats drops at the end of the warm-up.
+//LRU, the pseudo-LRU policies and the RRIP policies leave a block that is hit again right after a hit where the
+//first hit put it, so when the same block comes again only the clock and its dirty bit have to change. LRU and the
+//pseudo-LRU policies also leave a block they just brought in where a hit would, see LRU_replace, RRIP inserts it
+//with a higher RRPV than a hit. Most accesses of a trace with any spatial locality are like that, LFU and LRFU
+//count every one of them
+template<int REP, int WR, int VIC>
+void Cache::warm(unsigned long long address, char r_or_w){
+  const int wr=(WR==POLICY_DYNAMIC) ? write_policy : WR;
+  const int rep=(REP==POLICY_DYNAMIC) ? replace_policy : REP;
+  uint64_t tag;
+  int set;
+  int index_of_hit;
+  int vh_index=-1;
+  read_or_write=r_or_w;
+  address&=address_mask;
+  if(classifier!=NULL) classifier->warm(address);
+  if(rep!=REPLACE_LFU && rep!=REPLACE_LRFU && warm_way>=0 && (address>>block_bits)==warm_block){
+    global_counter++;
+    if(r_or_w=='w'){
+      if(wr==WRITE_WBWA) set_dirty(warm_set,warm_way,1);
+      else issue_to_next(address,'w');
+    }
+    return;
   }
+  tag=address>>(set_bits+block_bits);
+  set=(int)((address>>block_bits)&((1ULL<<set_bits)-1));
+  index_of_hit=hit_or_miss(tag, set);
+  global_counter++;
+  if(index_of_hit!=-1){
+    if(r_or_w=='w'){
+      if(wr==WRITE_WBWA) set_dirty(set,index_of_hit,1);
+      else issue_to_next(address,'w');
+    }
+    update<REP>(tag,set,index_of_hit);
+    warm_block=address>>block_bits;
+    warm_set=set;
+    warm_way=index_of_hit;
+    return;
+  }
+  if(victim!=NULL) vh_index=victim->hit_or_miss(address>>block_bits,0);
+  //swap with the victim cache
+  if(vh_index!=-1){
+    victim->LRU_update(address>>block_bits,0, vh_index);
+    swap=1;
+    replace<REP,VIC>(tag,set,address,vh_index);
+    swap=0;
+  }
+  else if(r_or_w=='r' || wr==WRITE_WBWA) replace<REP,VIC>(tag,set,address,0);
+  else issue_to_next(address,'w');
+}
+
+
+
+
+//update the counters of the replacement policy on a hit
+template<int REP>
+inline void Cache::update(uint64_t tag, int set, int hit){
+  const int rep=(REP==POLICY_DYNAMIC) ? replace_policy : REP;
+  if(rep==REPLACE_LRU) LRU_update(tag,set,hit);
+  else if(rep==REPLACE_LFU) LFU_update(tag,set,hit);
+  else if(rep==REPLACE_TREE_PLRU) tree_touch(set,hit);
+  else if(rep==REPLACE_BIT_PLRU) bit_touch(set,hit);
+  else if(rep>=REPLACE_SRRIP) rrip_set(set,hit,0);
+  else LRFU_update(tag,set,hit);
+}
+
+
+
+//find a block to replace on a miss or a swap with the replacement policy
+template<int REP, int VIC>
+inline void Cache::replace(uint64_t tag, int set, unsigned long long address, int victim_index){
+  const int rep=(REP==POLICY_DYNAMIC) ? replace_policy : REP;
+  warm_way=-1;
+  if(rep==REPLACE_LFU) LFU_replace<VIC>(tag,set,address,victim_index);
+  else if(rep==REPLACE_LRFU) LRFU_replace<VIC>(tag,set,address,victim_index);
+  else LRU_replace<REP,VIC>(tag,set,address,victim_index);
+}
+
+
+
+
+//function for updating on the LRU policy
+void Cache::LRU_update(uint64_t tag, int set, int hit){
+  //move the block to the front of the recency list of its set
+  lru_touch(set,hit,1);
 }
 
 
 
 
 //function for updating on the LRFU policy                                                                                                                                                                 
-void Cache::LRFU_update(int tag, int set, int hit){
-  //calculate new CRF for accessed block
-  set_array[set][hit].CRF=(double)1+(pow((1.0/2.0),((double)global_counter-(double)set_array[set][hit].last_time_stamp)*lambda)*set_array[set][hit].CRF);
-  set_array[set][hit].last_time_stamp=global_counter;
+void Cache::LRFU_update(uint64_t tag, int set, int hit){
+  //calculate new CRF for accessed block, the decay factor comes from the table instead of pow
+  CRF[blk(set,hit)]=(double)1+(decay(global_counter-last_time_stamp[blk(set,hit)])*CRF[blk(set,hit)]);
+  last_time_stamp[blk(set,hit)]=global_counter;
+  //move the block in the ordered structure of its set
+  if(lrfu_key!=NULL) lrfu_touch(set,hit);
 }
 
 
 
 
 //function to find the right block to evict in the set on LRFU policy
-void Cache::LRFU_replace(int tag, int set, unsigned long long address, int victim_index){
+template<int VIC>
+void Cache::LRFU_replace(uint64_t tag, int set, unsigned long long address, int victim_index){
   int index0;
   int found0;
   double lowest_CRF;
   int lowest_index=0;
   int hold_dirty;
-  double temporary_CRF[blk_per_set];
+  double temporary_CRF;
   unsigned long long write_back_address=0;
   unsigned long long victim_address=0;
   found0=0;
   lowest_index=0;
   //look to see if vacant spot in the set
-  for(int i=0; i<blk_per_set;i++){
-    if(found0==0){
-      //found a vacant block
-      if(set_array[set][i].valid==0){
-	index0=i;
-	found0=1;
-	//issue the read to the next level, only if you arent a vicitim cache
-	if(strcmp(cache_name,"Victim")!=0)issue_to_next(address,'r');
-	//update the block and dirty if it is a write
-	set_array[set][i].tag=tag;
-	//set CRF and last time ref
-	set_array[set][i].CRF=1.0;
-	set_array[set][i].last_time_stamp=global_counter;
-	set_array[set][i].dirty=0;
-	set_array[set][i].valid=1;
-	
-	//dirty the block if we need to
-	if(read_or_write=='w') set_array[set][i].dirty=1;
-      }
-    }
+  index0=find_invalid(set);
+  if(index0!=-1){
+    //found a vacant block
+    found0=1;
+    //issue the read to the next level, only if you arent a vicitim cache
+    if(!victim_role<VIC>() && swap==0)issue_to_next(address,'r');
+    //update the block and dirty if it is a write
+    write_tag(set,index0,tag);
+    //set CRF and last time ref
+    CRF[blk(set,index0)]=1.0;
+    last_time_stamp[blk(set,index0)]=global_counter;
+    set_dirty(set,index0,0);
+    set_valid(set,index0);
+    if(lrfu_key!=NULL) lrfu_touch(set,index0);
+
+    //dirty the block if we need to
+    if(read_or_write=='w') set_dirty(set,index0,1);
+    //a swap can only find an empty way after a coherence invalidation
+    if(swap==1) take_from_victim(set,index0,victim_index);
   }
   //if did not find invalid to evict, look for a valid one
   if(found0==0){
-    //calculate temporary CRF values
-    for(int i=0; i<blk_per_set;i++){
-      temporary_CRF[i]=(pow((1.0/2.0),((double)global_counter-(double)set_array[set][i].last_time_stamp)*lambda)*set_array[set][i].CRF);
-    }
-    lowest_CRF=temporary_CRF[0];
-    //look for lowest CRF value
-    for(int i=0; i<blk_per_set; i++){
-      if(lowest_CRF>temporary_CRF[i]){
-	lowest_CRF=temporary_CRF[i];
-	lowest_index=i;
+    //high associativity sets keep their blocks ordered, so the victim is found without a scan
+    if(lrfu_key!=NULL) lowest_index=lrfu_victim(set);
+    else{
+      //calculate temporary CRF values and look for lowest CRF value
+      lowest_CRF=decay(global_counter-last_time_stamp[blk(set,0)])*CRF[blk(set,0)];
+      for(int i=1; i<blk_per_set; i++){
+	temporary_CRF=decay(global_counter-last_time_stamp[blk(set,i)])*CRF[blk(set,i)];
+	if(lowest_CRF>temporary_CRF){
+	  lowest_CRF=temporary_CRF;
+	  lowest_index=i;
+	}
       }
     }
     //now we know the block who had the lowest temp CRF
     //If we are evicting and have a victim cache, need to call victim cache replace with the old block being replace                                                              
     if(swap==0 && victim!=NULL){
-      victim_address=((unsigned long long)set_array[set][lowest_index].tag)<<(set_bits+block_bits);
+      victim_address=((unsigned long long)tag_of(set,lowest_index))<<(set_bits+block_bits);
       victim_address=victim_address+((unsigned long long)set<<block_bits);
-      if(set_array[set][lowest_index].dirty==1) victim->read_or_write='w';
+      if(is_dirty(set,lowest_index)) victim->read_or_write='w';
       else victim->read_or_write='r';
-      victim->LRU_replace(victim_address>>block_bits,0,victim_address,0);
+      victim->LRU_replace<REPLACE_LRU,VIC==POLICY_DYNAMIC ? POLICY_DYNAMIC : 1>(victim_address>>block_bits,0,victim_address,0);
     }
 
     //only want to issue to a next level if this is not a swap
     if(swap==0){
       //if this block is dirty write it back, but only if it does not have a victim cache
       //victim cache handles all writebacks for a certain level
-      if(set_array[set][lowest_index].dirty==1){
+      if(is_dirty(set,lowest_index)){
 	if(victim==NULL){
 	  //issue write back, need to construct the address into an appropriate value for the issue_to_next function call
-	  write_back_address=((unsigned long long)set_array[set][lowest_index].tag&0x00000000FFFFFFFF)<<(set_bits+block_bits);
+	  write_back_address=((unsigned long long)tag_of(set,lowest_index))<<(set_bits+block_bits);
 	  write_back_address=write_back_address+((unsigned long long)set<<block_bits);
 	  issue_to_next(write_back_address,'w');
 	  //increment write back counter
@@ -287,29 +579,30 @@ void Cache::LRFU_replace(int tag, int set, unsigned long long address, int victi
 	}
       }
       //issue read to lower level as long as you are not a vicitm cache
-      if(strcmp(cache_name,"Victim")!=0)issue_to_next(address,'r');
+      if(!victim_role<VIC>())issue_to_next(address,'r');
     }
 
     //update the block with new information
     //if we have a swap we need to swap blocks with the victim
     //need to give the victim the cache's dirty bit, and need to update victim to have appropriate tag
     if(swap==1 && victim!=NULL){
-      victim_address=((unsigned long long)set_array[set][lowest_index].tag)<<(set_bits+block_bits);
+      victim_address=((unsigned long long)tag_of(set,lowest_index))<<(set_bits+block_bits);
       victim_address=victim_address+((unsigned long long)set<<block_bits);
-      hold_dirty=set_array[set][lowest_index].dirty;
-      set_array[set][lowest_index].dirty=victim->set_array[0][victim_index].dirty;
-      victim->set_array[0][victim_index].tag=victim_address>>block_bits;
-      victim->set_array[0][victim_index].dirty=hold_dirty;
+      hold_dirty=is_dirty(set,lowest_index);
+      set_dirty(set,lowest_index,victim->is_dirty(0,victim_index));
+      victim->write_tag(0,victim_index,victim_address>>block_bits);
+      victim->set_dirty(0,victim_index,hold_dirty);
     }
     //load in a new block for the cache
-    set_array[set][lowest_index].tag=tag;
-    set_array[set][lowest_index].CRF=(double)1.0;
-    set_array[set][lowest_index].last_time_stamp=global_counter;
+    write_tag(set,lowest_index,tag);
+    CRF[blk(set,lowest_index)]=(double)1.0;
+    last_time_stamp[blk(set,lowest_index)]=global_counter;
+    if(lrfu_key!=NULL) lrfu_touch(set,lowest_index);
     if(swap==0){
-      set_array[set][lowest_index].dirty=0;
+      set_dirty(set,lowest_index,0);
     }
       //If WBWA miss we need to dirty this new block, only if not a victim
-    if(read_or_write=='w') set_array[set][lowest_index].dirty=1;
+    if(read_or_write=='w') set_dirty(set,lowest_index,1);
   }  
 }
 
@@ -318,64 +611,55 @@ void Cache::LRFU_replace(int tag, int set, unsigned long long address, int victi
 
 
 //function for updating on the LFU policy
-void Cache::LFU_update(int tag, int set, int hit){
-  //update the LRU order for printing
-  update_Print_LRU(tag,set,hit);
+void Cache::LFU_update(uint64_t tag, int set, int hit){
   //when you hit on a LFU policy just update the age counter
-  set_array[set][hit].age++;
+  ages[blk(set,hit)]++;
 }
     
 
 
-//function to find the right block to evict in the set on LRU policy
-void Cache::LRU_replace(int tag, int set, unsigned long long address, int victim_index){
+//function to find the right block to evict in the set on LRU policy, or on one of the pseudo-LRU policies
+template<int REP, int VIC>
+void Cache::LRU_replace(uint64_t tag, int set, unsigned long long address, int victim_index){
+  const int rep=(REP==POLICY_DYNAMIC) ? replace_policy : REP;
   int index0;
   int found0;
-  int oldest_age;
   int oldest_index;
   int hold_dirty;
   unsigned long long write_back_address=0;
   unsigned long long victim_address=0;
   found0=0;
-  oldest_age=set_array[set][0].age;
   oldest_index=0;
   //look to see if vacant spot in the set
-  for(int i=0; i<blk_per_set;i++){
-    if(found0==0){
-      //found a vacant block
-      if(set_array[set][i].valid==0){
-	index0=i;
-	found0=1;
-	//issue the read to the next level, only if you arent a vicitim cache
-	if(strcmp(cache_name,"Victim")!=0)issue_to_next(address,'r');
-	//update the block and dirty if it is a write
-	set_array[set][i].tag=tag;
-	//set age back to zero
-	set_array[set][i].print_LRU=0;
-	set_array[set][i].age=0;
-	set_array[set][i].dirty=0;
-	set_array[set][i].valid=1;
-	//dirty the block if we need to
-	if(read_or_write=='w') set_array[set][i].dirty=1;
-      }
-    }
+  index0=find_invalid(set);
+  if(index0!=-1){
+    //found a vacant block
+    found0=1;
+    //issue the read to the next level, only if you arent a vicitim cache
+    if(!victim_role<VIC>() && swap==0)issue_to_next(address,'r');
+    //update the block and dirty if it is a write
+    write_tag(set,index0,tag);
+    set_dirty(set,index0,0);
+    set_valid(set,index0);
+    //dirty the block if we need to
+    if(read_or_write=='w') set_dirty(set,index0,1);
+    //a swap can only find an empty way after a coherence invalidation
+    if(swap==1) take_from_victim(set,index0,victim_index);
   }
   //if did not find invalid to evict, look for a valid one
   if(found0==0){
-    //look through all the blocks in the set and find the one with the highest counter
-    for(int i=0; i<blk_per_set; i++){
-      if(set_array[set][i].age>oldest_age){
-	oldest_age=set_array[set][i].age;
-	oldest_index=i;
-      }
-    }
+    //the least recently used block is at the end of the recency list, the pseudo-LRU policies follow their bits
+    if(rep==REPLACE_TREE_PLRU) oldest_index=tree_victim(set);
+    else if(rep==REPLACE_BIT_PLRU) oldest_index=bit_victim(set);
+    else if(rep>=REPLACE_SRRIP) oldest_index=rrip_victim(set);
+    else oldest_index=lru_tail[set];
     //If we are evicting and haev a victim cache, need to call victim cache replace with the old block being replaced                                                                                       
     if(swap==0 && victim!=NULL){
-      victim_address=((unsigned long long)set_array[set][oldest_index].tag)<<(set_bits+block_bits);
+      victim_address=((unsigned long long)tag_of(set,oldest_index))<<(set_bits+block_bits);
       victim_address=victim_address+((unsigned long long)set<<block_bits);
-      if(set_array[set][oldest_index].dirty==1) victim->read_or_write='w';
+      if(is_dirty(set,oldest_index)) victim->read_or_write='w';
       else victim->read_or_write='r';
-      victim->LRU_replace(victim_address>>block_bits,0,victim_address,0);
+      victim->LRU_replace<REPLACE_LRU,VIC==POLICY_DYNAMIC ? POLICY_DYNAMIC : 1>(victim_address>>block_bits,0,victim_address,0);
     }
 
     //only want to issue to a next level if this is not a swap
@@ -383,10 +667,10 @@ void Cache::LRU_replace(int tag, int set, unsigned long long address, int victim
       //now we know the oldest block in the set
       //if this block is dirty write it back, but only if it does not have a victim cache
       //victim cache handles all writebacks for a certain level
-      if(set_array[set][oldest_index].dirty==1){
+      if(is_dirty(set,oldest_index)){
 	if(victim==NULL){
 	  //issue write back, need to construct the address into an appropriate value for the issue_to_next function call
-	  write_back_address=((unsigned long long)set_array[set][oldest_index].tag&0x00000000FFFFFFFF)<<(set_bits+block_bits);
+	  write_back_address=((unsigned long long)tag_of(set,oldest_index))<<(set_bits+block_bits);
 	  write_back_address=write_back_address+((unsigned long long)set<<block_bits);
 	  issue_to_next(write_back_address,'w');
 	  //increment write back counter
@@ -394,39 +678,41 @@ void Cache::LRU_replace(int tag, int set, unsigned long long address, int victim
 	}
       }
       //issue read to lower level as long as you are not a vicitm cache
-      if(strcmp(cache_name,"Victim")!=0)issue_to_next(address,'r');
+      if(!victim_role<VIC>())issue_to_next(address,'r');
     }
 
     //update the block with new information
     //if we have a swap we need to swap blocks with the victim
     //need to give the victim the caches dirty bit, and need to update victim to have appropriate tag
     if(swap==1 && victim!=NULL){
-      victim_address=((unsigned long long)set_array[set][oldest_index].tag)<<(set_bits+block_bits);
+      victim_address=((unsigned long long)tag_of(set,oldest_index))<<(set_bits+block_bits);
       victim_address=victim_address+((unsigned long long)set<<block_bits);
-      hold_dirty=set_array[set][oldest_index].dirty;
-      set_array[set][oldest_index].dirty=victim->set_array[0][victim_index].dirty;
-      victim->set_array[0][victim_index].tag=victim_address>>block_bits;
-      victim->set_array[0][victim_index].dirty=hold_dirty;
+      hold_dirty=is_dirty(set,oldest_index);
+      set_dirty(set,oldest_index,victim->is_dirty(0,victim_index));
+      victim->write_tag(0,victim_index,victim_address>>block_bits);
+      victim->set_dirty(0,victim_index,hold_dirty);
     }
     //if we got here normally, then we are evicting a block
 			      
-    set_array[set][oldest_index].tag=tag;
-    set_array[set][oldest_index].age=0;
-    set_array[set][oldest_index].print_LRU=0;
+    write_tag(set,oldest_index,tag);
     if(swap==0){
-      set_array[set][oldest_index].dirty=0;
+      set_dirty(set,oldest_index,0);
     }
       //If WBWA miss we need to dirty this new block, only if not a victim
-    if(read_or_write=='w') set_array[set][oldest_index].dirty=1;
+    if(read_or_write=='w') set_dirty(set,oldest_index,1);
   } 
   if(found0==1) oldest_index=index0;
-  //go through and update the age of all other valid blocks
-  for(int i=0; i<blk_per_set; i++){
-    if(set_array[set][i].valid==1 && i!= oldest_index){
-      set_array[set][i].age++;
-      set_array[set][i].print_LRU++;
-    }
-  }  
+  //the new block is the most recently used one, an empty way is not in the recency list yet
+  if(rep==REPLACE_TREE_PLRU) tree_touch(set,oldest_index);
+  else if(rep==REPLACE_BIT_PLRU) bit_touch(set,oldest_index);
+  else if(rep>=REPLACE_SRRIP) rrip_insert(set,oldest_index,rep);
+  else lru_touch(set,oldest_index,found0==0);
+  //the new block is where a hit on it would leave it, see warm
+  if(rep<REPLACE_SRRIP){
+    warm_block=address>>block_bits;
+    warm_set=set;
+    warm_way=oldest_index;
+  }
 }
 
 
@@ -435,12 +721,80 @@ void Cache::LRU_replace(int tag, int set, unsigned long long address, int victim
 
 
 
+#if defined(__AVX2__) || defined(__SSE2__)
+//bitmask of the tags among the first count of a set that match, count is a multiple of the SIMD ways, at most 64
+static inline uint64_t match_wide(const uint64_t* set_tags, int count, uint64_t tag){
+  uint64_t match=0;
+#ifdef __AVX2__
+  __m256i key=_mm256_set1_epi64x((long long)tag);
+  for(int i=0;i<count;i+=4){
+    __m256i lanes=_mm256_cmpeq_epi64(_mm256_load_si256((const __m256i*)&set_tags[i]),key);
+    match|=(uint64_t)(uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(lanes))<<i;
+  }
+#else
+  __m128i key=_mm_set1_epi64x((long long)tag);
+  for(int i=0;i<count;i+=2){
+    //SSE2 has no 64 bit compare, a tag matches when both of its 32 bit halves do
+    __m128i lanes=_mm_cmpeq_epi32(_mm_load_si128((const __m128i*)&set_tags[i]),key);
+    lanes=_mm_and_si128(lanes,_mm_shuffle_epi32(lanes,_MM_SHUFFLE(2,3,0,1)));
+    match|=(uint64_t)(uint32_t)_mm_movemask_pd(_mm_castsi128_pd(lanes))<<i;
+  }
+#endif
+  return match;
+}
+
+
+
+//the same for tags stored in 32 bits, which fit twice as many in a register
+static inline uint64_t match_narrow(const uint32_t* set_tags, int count, uint32_t tag){
+  uint64_t match=0;
+#ifdef __AVX2__
+  __m256i key=_mm256_set1_epi32((int)tag);
+  for(int i=0;i<count;i+=8){
+    __m256i lanes=_mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)&set_tags[i]),key);
+    match|=(uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(lanes))<<i;
+  }
+#else
+  __m128i key=_mm_set1_epi32((int)tag);
+  for(int i=0;i<count;i+=4){
+    __m128i lanes=_mm_cmpeq_epi32(_mm_load_si128((const __m128i*)&set_tags[i]),key);
+    match|=(uint64_t)(uint32_t)_mm_movemask_ps(_mm_castsi128_ps(lanes))<<i;
+  }
+#endif
+  return match;
+}
+#endif
+
+
+
 //function to find the index of the cache hit
-int Cache::hit_or_miss(int tag, int set){
+int Cache::hit_or_miss(uint64_t tag, int set){
+  //large fully associative caches look the tag up in their index
+  if(fa_index!=NULL){
+    uint64_t* way=fa_index->find(tag);
+    return way!=NULL ? (int)*way : -1;
+  }
+#if defined(__AVX2__) || defined(__SSE2__)
+  //compare every tag in the set at once, then keep only the matches on valid blocks
+  if(assoc>=simd_ways){
+    const uint64_t* valid=&valid_bits[set*mask_words];
+    for(int w=0;w<mask_words;w++){
+      int base=w*64;
+      int count=(tag_stride<base+64 ? tag_stride : base+64)-base;
+      uint64_t match;
+      if(tag_bytes==4) match=match_narrow(&((const uint32_t*)tags)[blk(set,base)],count,(uint32_t)tag);
+      else match=match_wide(&((const uint64_t*)tags)[blk(set,base)],count,tag);
+      match&=valid[w];
+      //the lowest matching way is the hit
+      if(match!=0) return base+__builtin_ctzll(match);
+    }
+    return -1;
+  }
+#endif
   //scan through all the blocks in the correct set
   //if tag matches and block is valid return the index for it
   for(int i=0; i<blk_per_set;i++){
-    if(set_array[set][i].tag==tag && set_array[set][i].valid==1) return i;
+    if(tag_of(set,i)==tag && is_valid(set,i)) return i;
   }
   //no match.... return -1
   return -1;
@@ -448,11 +802,177 @@ int Cache::hit_or_miss(int tag, int set){
 
 
 
+//move a way to the front of the recency list of its set, linked is 0 if it is not in the list yet
+void Cache::lru_touch(int set, int way, int linked){
+  uint32_t head=lru_head[set];
+  if(linked){
+    if(head==(uint32_t)way) return;
+    lru_unlink(set,way);
+    head=lru_head[set];
+  }
+  lru_prev[blk(set,way)]=LRU_NONE;
+  lru_next[blk(set,way)]=head;
+  if(head!=LRU_NONE) lru_prev[blk(set,head)]=way;
+  else lru_tail[set]=way;
+  lru_head[set]=way;
+}
+
+
+
+//take a way out of the recency list of its set
+void Cache::lru_unlink(int set, int way){
+  uint32_t prev=lru_prev[blk(set,way)];
+  uint32_t next=lru_next[blk(set,way)];
+  if(prev!=LRU_NONE) lru_next[blk(set,prev)]=next;
+  else lru_head[set]=next;
+  if(next!=LRU_NONE) lru_prev[blk(set,next)]=prev;
+  else lru_tail[set]=prev;
+}
+
+
+
+//point every node on the path from the root to the way at the other half
+void Cache::tree_touch(int set, int way){
+  uint64_t* bits=&plru_bits[set*plru_words];
+  int node=1;
+  for(int level=plru_levels-1;level>=0;level--){
+    int right=(way>>level)&1;
+    if(right) bits[node>>6]&=~(1ULL<<(node&63));
+    else bits[node>>6]|=1ULL<<(node&63);
+    node=node*2+right;
+  }
+}
+
+
+
+//follow the bits from the root, never in to a half that only holds ways past the associativity
+int Cache::tree_victim(int set){
+  const uint64_t* bits=&plru_bits[set*plru_words];
+  int node=1;
+  int way=0;
+  for(int level=plru_levels-1;level>=0;level--){
+    int right=(int)((bits[node>>6]>>(node&63))&1);
+    if(right && (((way<<1)|1)<<level)>=assoc) right=0;
+    way=(way<<1)|right;
+    node=node*2+right;
+  }
+  return way;
+}
+
+
+
+void Cache::bit_touch(int set, int way){
+  uint64_t* bits=&plru_bits[set*plru_words];
+  int full=1;
+  bits[way>>6]|=1ULL<<(way&63);
+  for(int w=0;w<mask_words && full;w++){
+    int ways=assoc-w*64;
+    uint64_t all=ways>=64 ? ~0ULL : (1ULL<<ways)-1;
+    full=bits[w]==all;
+  }
+  //every way was used, so start over from just this one
+  if(full){
+    memset(bits,0,plru_words*sizeof(uint64_t));
+    bits[way>>6]=1ULL<<(way&63);
+  }
+}
+
+
+
+//the first way whose bit is clear
+int Cache::bit_victim(int set){
+  const uint64_t* bits=&plru_bits[set*plru_words];
+  for(int w=0;w<mask_words;w++){
+    int ways=assoc-w*64;
+    uint64_t all=ways>=64 ? ~0ULL : (1ULL<<ways)-1;
+    uint64_t clear=~bits[w]&all;
+    if(clear!=0) return w*64+__builtin_ctzll(clear);
+  }
+  return 0;
+}
+
+
+
+void Cache::rrip_set(int set, int way, int value){
+  uint64_t bit=1ULL<<(way&63);
+  int word=set*mask_words+(way>>6);
+  if(value&1) rrip_low[word]|=bit;
+  else rrip_low[word]&=~bit;
+  if(value&2) rrip_high[word]|=bit;
+  else rrip_high[word]&=~bit;
+}
+
+
+
+//the first way with a distant RRPV, after aging the whole set until there is one. Every RRPV is below
+//RRIP_DISTANT while aging, so adding one to all of them at once is just a carry from the low bits to the high bits
+int Cache::rrip_victim(int set){
+  uint64_t* low=&rrip_low[set*mask_words];
+  uint64_t* high=&rrip_high[set*mask_words];
+  for(;;){
+    for(int w=0;w<mask_words;w++){
+      int ways=assoc-w*64;
+      uint64_t all=ways>=64 ? ~0ULL : (1ULL<<ways)-1;
+      uint64_t distant=low[w]&high[w]&all;
+      if(distant!=0) return w*64+__builtin_ctzll(distant);
+    }
+    for(int w=0;w<mask_words;w++){
+      high[w]^=low[w];
+      low[w]=~low[w];
+    }
+  }
+}
+
+
+
+//sets the RRPV of a new block, and on a miss in a leader set of DRRIP moves the counter away from its policy
+void Cache::rrip_insert(int set, int way, int policy){
+  if(policy==REPLACE_DRRIP){
+    int leader=rrip_stride>0 ? set%rrip_stride : -1;
+    if(leader==0){
+      policy=REPLACE_SRRIP;
+      if(swap==0 && rrip_psel<(1<<RRIP_PSEL_BITS)-1) rrip_psel++;
+    }
+    else if(leader==rrip_stride/2){
+      policy=REPLACE_BRRIP;
+      if(swap==0 && rrip_psel>0) rrip_psel--;
+    }
+    //the followers use BRRIP once SRRIP missed more, which sets the top bit of the counter
+    else policy=rrip_psel>=(1<<(RRIP_PSEL_BITS-1)) ? REPLACE_BRRIP : REPLACE_SRRIP;
+  }
+  if(policy==REPLACE_BRRIP){
+    if(++rrip_bimodal<RRIP_BIMODAL){
+      rrip_set(set,way,RRIP_DISTANT);
+      return;
+    }
+    rrip_bimodal=0;
+  }
+  rrip_set(set,way,RRIP_LONG);
+}
+
+
+
+//function to find the first vacant block in a set
+int Cache::find_invalid(int set){
+  const uint64_t* valid=&valid_bits[set*mask_words];
+  for(int w=0;w<mask_words;w++){
+    uint64_t vacant=~valid[w];
+    if(vacant!=0){
+      int way=w*64+__builtin_ctzll(vacant);
+      return way<assoc ? way : -1;
+    }
+  }
+  return -1;
+}
+
+
+
 
 
 
 //function to replace a block on LFU policy
-void Cache::LFU_replace(int tag, int set, unsigned long long address,int victim_index){
+template<int VIC>
+void Cache::LFU_replace(uint64_t tag, int set, unsigned long long address,int victim_index){
   int index0;
   int found0;
   int least_freq;
@@ -461,110 +981,217 @@ void Cache::LFU_replace(int tag, int set, unsigned long long address,int victim_
   unsigned long long write_back_address=0;
   unsigned long long victim_address;
   found0=0;
-  least_freq=set_array[set][0].age;
+  least_freq=ages[blk(set,0)];
   least_index=0;
   //look to see if vacant spot in the set                                                                                                                                                                  
-  for(int i=0; i<blk_per_set;i++){
-    if(found0==0){
-      //found a vacant block                                                                                                                                                                               
-      if(set_array[set][i].valid==0){
-        index0=i;
-        found0=1;
-        //issue the read to the next leveL
-	if(strcmp(cache_name,"Victim")!=0)issue_to_next(address,'r');
-        //update the block and dirty if it is a write                                                                                                                                                      
-        set_array[set][i].tag=tag;
-        //set block counter (age) to 1, since the set counter will be 0 if there are still vacant spots                                                                                                            
-	set_array[set][i].print_LRU=0;   
-        set_array[set][i].age=1;
-        set_array[set][i].dirty=0;
-        set_array[set][i].valid=1;
-        if(read_or_write=='w') set_array[set][i].dirty=1;
-      }
-    }
+  index0=find_invalid(set);
+  if(index0!=-1){
+    //found a vacant block
+    found0=1;
+    //issue the read to the next leveL
+    if(!victim_role<VIC>() && swap==0)issue_to_next(address,'r');
+    //update the block and dirty if it is a write
+    write_tag(set,index0,tag);
+    //set block counter (age) to 1, since the set counter will be 0 if there are still vacant spots
+    ages[blk(set,index0)]=1;
+    set_dirty(set,index0,0);
+    set_valid(set,index0);
+    if(read_or_write=='w') set_dirty(set,index0,1);
+    //a swap can only find an empty way after a coherence invalidation
+    if(swap==1) take_from_victim(set,index0,victim_index);
   }
   //if did not find invalid to evict, look for a valid one                                        
   if(found0==0){
     //scan through all the blocks in a set
     //find the block with the smallest age counter (indicates least frequently used)
     for(int i=0; i<blk_per_set; i++){
-      if(set_array[set][i].age<least_freq){
-        least_freq=set_array[set][i].age;
+      if(ages[blk(set,i)]<least_freq){
+        least_freq=ages[blk(set,i)];
         least_index=i;
       }
     }
     //if we are normally evicting a block then we have to place the evicted block into the victim cache                                                                                                     
     if(swap==0 && victim!=NULL){
-      victim_address=((unsigned long long)set_array[set][least_index].tag)<<(set_bits+block_bits);
+      victim_address=((unsigned long long)tag_of(set,least_index))<<(set_bits+block_bits);
       victim_address=victim_address+((unsigned long long)set<<block_bits);
-      if(set_array[set][least_index].dirty==1) victim->read_or_write='w';
+      if(is_dirty(set,least_index)) victim->read_or_write='w';
       else victim->read_or_write='r';
-      victim->LRU_replace((unsigned long long)victim_address>>block_bits,0,victim_address,0);
+      victim->LRU_replace<REPLACE_LRU,VIC==POLICY_DYNAMIC ? POLICY_DYNAMIC : 1>((unsigned long long)victim_address>>block_bits,0,victim_address,0);
     }
 
     if(swap==0){
       //now we know the least frequent  block in the set                          
       //if this block is dirty write it back                                                        
-      if(set_array[set][least_index].dirty==1 && victim==NULL){
+      if(is_dirty(set,least_index) && victim==NULL){
 	//issue write back       
 	//calculate appropriate address for the next level cache
-	write_back_address=((unsigned long long)set_array[set][least_index].tag)<<(set_bits+block_bits);
+	write_back_address=((unsigned long long)tag_of(set,least_index))<<(set_bits+block_bits);
 	write_back_address=write_back_address+((unsigned long long)set<<block_bits);
 	issue_to_next(write_back_address,'w');
 	write_backs++;
       }
       //issue read to lower level    
-      if(strcmp(cache_name,"Victim")!=0)issue_to_next(address,'r');
+      if(!victim_role<VIC>())issue_to_next(address,'r');
     }
     //if we have a swap we need to swap blocks with the victim
     if(swap==1){
-      victim_address=((unsigned long long)set_array[set][least_index].tag)<<(set_bits+block_bits);
+      victim_address=((unsigned long long)tag_of(set,least_index))<<(set_bits+block_bits);
       victim_address=victim_address+((unsigned long long)set<<block_bits);
-      victim->set_array[0][victim_index].tag=victim_address>>block_bits;
-      hold_dirty=set_array[set][least_index].dirty;
-      set_array[set][least_index].dirty=victim->set_array[0][victim_index].dirty;
-      victim->set_array[0][victim_index].dirty=hold_dirty;
+      victim->write_tag(0,victim_index,victim_address>>block_bits);
+      hold_dirty=is_dirty(set,least_index);
+      set_dirty(set,least_index,victim->is_dirty(0,victim_index));
+      victim->set_dirty(0,victim_index,hold_dirty);
     }
     
     //update the block with new information
-    set_counters[set]=set_array[set][least_index].age;
-    set_array[set][least_index].tag=tag;
+    set_counters[set]=ages[blk(set,least_index)];
+    write_tag(set,least_index,tag);
     //set the new block's counter equal to the set counter +1
-    set_array[set][least_index].age=set_counters[set]+1;
-    update_Print_LRU(0,set,least_index);
-    if(swap==0)set_array[set][least_index].dirty=0;
+    ages[blk(set,least_index)]=set_counters[set]+1;
+    if(swap==0)set_dirty(set,least_index,0);
     //dirty the block if WBWA 
-    if(read_or_write=='w') set_array[set][least_index].dirty=1;
+    if(read_or_write=='w') set_dirty(set,least_index,1);
   }
 
 }
 
-// print the contents of the cache and the report for statistics out
-void Cache::report(){
-  //calculate miss rate
-  miss_rate=((float)write_miss+(float)read_miss)/((float)num_reads+(float)num_writes);
+// calculate the statistics of the cache from the raw counters
+void Cache::calculate_stats(){
+  //calculate miss rate, the counts are added up before they are converted so nothing is lost past 2^24
+  miss_rate=(float)((double)(write_miss+read_miss)/(double)(num_reads+num_writes));
   //calculate the appropriate memory traffic depending on the write policy
   if(write_policy==0) mem_traffic=read_miss+write_miss+write_backs;
   else mem_traffic= read_miss+num_writes;
   average_time=hit_time+(miss_rate*miss_penalty);
-  
-  if(strcmp(cache_name,"Victim")!=0)printf("===== %s contents =====\n",cache_name);
-  else printf("===== Victim Cache contents =====\n");
-  //print the set, all the tags in the set, and if the block is dirty or not
-  for(int i=0;i<num_sets;i++){
-    printf("set     %i:   ",i);
-    for(int j=0; j<blk_per_set;j++){
-      if(set_array[i][j].valid==1){
-	  printf(" %X   ",set_array[i][j].tag);
-	  if(set_array[i][j].dirty==1)printf("  D  ");
-      }
-      else printf("  -   ");
-    }
-  
-    printf("\n");
+}
+
+
+
+//the counters of the whole cache are the sums of the ones of its parts
+void Cache::sum_counters(Cache** parts, int count){
+  num_reads=num_writes=read_miss=write_miss=write_backs=swaps=0;
+  for(int i=0;i<count;i++){
+    num_reads+=parts[i]->num_reads;
+    num_writes+=parts[i]->num_writes;
+    read_miss+=parts[i]->read_miss;
+    write_miss+=parts[i]->write_miss;
+    write_backs+=parts[i]->write_backs;
+    swaps+=parts[i]->swaps;
   }
+  write_policy=parts[0]->write_policy;
+  hit_time=parts[0]->hit_time;
+  miss_penalty=parts[0]->miss_penalty;
 }
-  
+
+
+
+//copy the counters out, so nothing outside the cache can change them
+void Cache::stats(struct cache_stats* out){
+  calculate_stats();
+  out->reads=num_reads;
+  out->writes=num_writes;
+  out->read_misses=read_miss;
+  out->write_misses=write_miss;
+  out->write_backs=write_backs;
+  out->swaps=swaps;
+  out->memory_traffic=mem_traffic;
+  out->miss_rate=miss_rate;
+  out->average_time=average_time;
+  out->hit_time=hit_time;
+  out->miss_penalty=miss_penalty;
+}
+
+void Cache::clear_stats(){
+  num_reads=num_writes=read_miss=write_miss=write_backs=swaps=mem_traffic=0;
+  miss_rate=average_time=0;
+  if(classifier!=NULL) classifier->clear_counts();
+}
+
+
+
+// print the contents of the cache and the report for statistics out
+void Cache::report(ContentsDump* out){
+  calculate_stats();
+  out->begin_level(is_victim ? "Victim Cache" : cache_name,num_sets,blk_per_set);
+  //the set, all the tags in the set, and if the block is dirty or not
+  for(int i=0;i<num_sets;i++) dump_set(out,i,i);
+}
+
+
+
+void Cache::dump_set(ContentsDump* out, int set, int label){
+  out->begin_set(label);
+  for(int j=0; j<blk_per_set;j++) out->add_block(j,is_valid(set,j),(unsigned long long)tag_of(set,j),is_dirty(set,j));
+  out->end_set();
+}
+
+
+
+//empties a block, the ordered LRFU state of an empty way is left as it is and redone when the way is filled again
+void Cache::clear_block(int set, int way){
+  warm_way=-1;
+  if(fa_index!=NULL) fa_index->erase(tag_of(set,way));
+  if(lru_prev!=NULL) lru_unlink(set,way);
+  else if(plru_bits!=NULL && replace_policy==REPLACE_BIT_PLRU) plru_bits[set*plru_words+(way>>6)]&=~(1ULL<<(way&63));
+  valid_bits[set*mask_words+(way>>6)]&=~(1ULL<<(way&63));
+  set_dirty(set,way,0);
+}
+
+
+
+//moves the block a swap hit in the victim cache in to an empty way, keeping its dirty bit
+void Cache::take_from_victim(int set, int way, int victim_index){
+  if(victim->is_dirty(0,victim_index)) set_dirty(set,way,1);
+  victim->clear_block(0,victim_index);
+}
+
+
+
+//way of the block that holds an address in this cache, -1 if it is not here
+int Cache::find_block(unsigned long long address, int* set){
+  address&=address_mask;
+  *set=(int)((address>>block_bits)&((1ULL<<set_bits)-1));
+  return hit_or_miss(address>>(set_bits+block_bits),*set);
+}
+
+
+
+int Cache::state_of(unsigned long long address){
+  int set;
+  int way=find_block(address,&set);
+  if(way<0) return victim!=NULL ? victim->state_of(address) : 0;
+  return is_dirty(set,way) ? 2 : 1;
+}
+
+
+
+int Cache::invalidate(unsigned long long address){
+  int set;
+  int way=find_block(address,&set);
+  if(way<0) return victim!=NULL ? victim->invalidate(address) : 0;
+  int state=is_dirty(set,way) ? 2 : 1;
+  clear_block(set,way);
+  return state;
+}
+
+
+
+int Cache::downgrade(unsigned long long address){
+  int set;
+  int way=find_block(address,&set);
+  if(way<0) return victim!=NULL ? victim->downgrade(address) : 0;
+  if(!is_dirty(set,way)) return 0;
+  set_dirty(set,way,0);
+  return 1;
+}
+
+
+
+void Cache::enable_classifier(int reuse_histogram){
+  if(num_sets==0 || classifier!=NULL) return;
+  classifier=new MissClassifier(block_bits,num_sets,(uint64_t)num_sets*assoc,reuse_histogram);
+}
+
 
 
 //wrapper function to issue a read or write to the next level
@@ -578,15 +1205,47 @@ void Cache::issue_to_next(unsigned long long address, char read_or_w){
 
 
 
-//function that keeps track of the LRU block
-//mostly needed to adhere to the new printing requirements
-void Cache::update_Print_LRU(int tag, int set, int hit){
-  int old_LRU=set_array[set][hit].print_LRU;
-  set_array[set][hit].print_LRU=0;
-  //update the block counters who are valid and less than the old counter of the accessed block                                                                                                            
-  for(int i=0;i<blk_per_set;i++){
-    if(set_array[set][i].print_LRU<old_LRU && set_array[set][i].valid==1 && i!=hit) set_array[set][i].print_LRU++;
+//A cache level with its replacement policy, write policy and victim role fixed at compile time
+template<int REP, int WR, int VIC>
+class CacheLevel : public Cache{
+ public:
+  using Cache::Cache;
+  void cache_in(unsigned long long address, char r_or_w){
+    access<REP,WR,VIC>(address,r_or_w);
+  }
+  void cache_in_batch(const unsigned long long* addresses, const char* ops, size_t count){
+    access_batch<REP,WR,VIC>(addresses,ops,count);
   }
+  void cache_warm(unsigned long long address, char r_or_w){
+    warm<REP,WR,VIC>(address,r_or_w);
+  }
+};
 
+//picks the CacheLevel for a write policy and victim role once the replacement policy is known
+template<int REP>
+static Cache* make_level(int wr_policy, int victim_role, int blocksize, int size, int ass, double rep_policy, Cache* next_cache, int level, const char* name, Cache* victim_c, int addr_bits, int shards){
+  if(victim_role) return new CacheLevel<REP,WRITE_WBWA,1>(blocksize,size,ass,rep_policy,wr_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  if(wr_policy==WRITE_WBWA) return new CacheLevel<REP,WRITE_WBWA,0>(blocksize,size,ass,rep_policy,wr_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  return new CacheLevel<REP,WRITE_WTNA,0>(blocksize,size,ass,rep_policy,wr_policy,next_cache,level,name,victim_c,addr_bits,shards);
+}
 
+
+
+//build a cache specialized for its policies, takes the same arguments as the Cache constructor
+Cache* make_cache(int blocksize, int size, int ass, double rep_policy, int wr_policy, Cache* next_cache, int level, const char* name, Cache* victim_c, int addr_bits, int shards){
+  int victim_role=(strcmp(name,"Victim")==0);
+  //a disabled cache is never accessed, so it does not need to be specialized
+  if(size<=0) return new Cache(blocksize,size,ass,rep_policy,wr_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  //victim caches only write back, so only WBWA is specialized for them
+  if(victim_role && wr_policy!=WRITE_WBWA) return new Cache(blocksize,size,ass,rep_policy,wr_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  switch(replace_policy_of(rep_policy)){
+  case REPLACE_LRU: return make_level<REPLACE_LRU>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  case REPLACE_LFU: return make_level<REPLACE_LFU>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  case REPLACE_TREE_PLRU: return make_level<REPLACE_TREE_PLRU>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  case REPLACE_BIT_PLRU: return make_level<REPLACE_BIT_PLRU>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  case REPLACE_SRRIP: return make_level<REPLACE_SRRIP>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  case REPLACE_BRRIP: return make_level<REPLACE_BRRIP>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  case REPLACE_DRRIP: return make_level<REPLACE_DRRIP>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  default: return make_level<REPLACE_LRFU>(wr_policy,victim_role,blocksize,size,ass,rep_policy,next_cache,level,name,victim_c,addr_bits,shards);
+  }
 }
@@ -11,26 +11,94 @@ Author: Kevin Volkel
 
 Description: This file is the header file for the cache class. It specifies
 all variables that are associated with the cache class. This class is used to instantiate a
-general cache memory that can be configured with various parameters. This file also contains a struct
-that is used to represent 1 block in a cache. The structure contains fields such as tag, dirty, and valid, and
-a counter variable used to keep track of the age of a block in a set for the two different replacement policies.
+general cache memory that can be configured with various parameters. The blocks of the cache are stored as a
+structure of arrays in one flat allocation: the tags of a set are next to each other so a lookup can compare
+all of them with SIMD instructions, the valid and dirty flags are packed into bitmasks, and the counters used
+by the replacement policies, like the age of a block, are kept in side arrays. Only the arrays of the replacement
+policy in use are allocated, and tags are stored in 32 bits when the tag field of an address fits in them, so an
+LRU block with a 32 bit tag takes 12 bytes plus its valid and dirty bits. The allocation comes from arena.h, which
+maps large caches on huge pages.
 
 More counters for added to this class for part B of the project. This includes the CRF counter, global counter, 
 and the last time stamp counter. All of these are needed for the LRFU replacement policy. More functions were also
 added in order to support LRFU, and the new required feature of the victim cache.
 
+The replacement policy, write policy and victim role can also be fixed at compile time. The body of cache_in is
+a template on all three, and make_cache builds a CacheLevel subclass that calls the specialized body, so
+the hot path of those caches has no policy branches. A Cache built with its constructor checks them at run time.
+
+Large fully associative caches, like the victim cache, keep a hash index from tag to way so a lookup does not
+scan every way. LRU caches keep a linked recency list in every set instead of ages, so hits and evictions are
+O(1) at any associativity. The tree and bit pseudo-LRU policies of real hardware only keep a few bits per set,
+and the RRIP policies keep a 2 bit re-reference prediction value (RRPV) per block, stored as two bitmasks.
+
 *****************************************************************************************************************/
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "block_map.h"
+#include "contents.h"
 #include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <math.h>
+
+//replacement policies
+#define REPLACE_LRU 0
+#define REPLACE_LFU 1
+#define REPLACE_LRFU 2
+#define REPLACE_TREE_PLRU 3
+#define REPLACE_BIT_PLRU 4
+#define REPLACE_SRRIP 5
+#define REPLACE_BRRIP 6
+#define REPLACE_DRRIP 7
+#define REPLACE_POLICIES 8
+//replacement arguments of the policies added after LRFU. They are negative, which is never a lambda of LRFU, so
+//every number the simulator always took keeps its meaning, and they are given by name on the command line
+#define REPLACEMENT_TREE_PLRU -1
+#define REPLACEMENT_BIT_PLRU -2
+#define REPLACEMENT_SRRIP -3
+#define REPLACEMENT_BRRIP -4
+#define REPLACEMENT_DRRIP -5
+//RRPV of a block predicted to be reused soon, inserted by SRRIP, and never reused, the one that gets evicted
+#define RRIP_LONG 2
+#define RRIP_DISTANT 3
+//BRRIP inserts one block out of this many with RRIP_LONG instead of RRIP_DISTANT
+#define RRIP_BIMODAL 32
+//DRRIP dedicates up to this many leader sets to each of SRRIP and BRRIP, and follows the one a saturating
+//counter of RRIP_PSEL_BITS bits says misses less
+#define RRIP_LEADERS 32
+#define RRIP_PSEL_BITS 10
+//write policies
+#define WRITE_WBWA 0
+#define WRITE_WTNA 1
+//fully associative caches with at least this many ways find their blocks with an index instead of a search
+#define FA_INDEX_WAYS 32
+//marks the end of the recency list of a set
+#define LRU_NONE 0xFFFFFFFFU
+//physical address width used when none is given, addresses are masked to this many bits
+#define CACHE_ADDRESS_BITS 64
+//template argument used when a policy is read from the cache at run time instead of fixed at compile time
+#define POLICY_DYNAMIC -1
+//how many accesses ahead cache_in_batch starts loading the set of an access
+#define CACHE_PREFETCH 4
+
+class MissClassifier;
 
-//structure that represents a cache block
-struct block{
-  int tag;
-  int age;
-  int dirty;
-  int valid;
-  int print_LRU;
-  double CRF;
-  int last_time_stamp;
+//statistics of one cache level, the counters and what calculate_stats works out from them
+struct cache_stats{
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t read_misses;
+  uint64_t write_misses;
+  uint64_t write_backs;
+  uint64_t swaps;
+  uint64_t memory_traffic;
+  double miss_rate;
+  double average_time;
+  //latencies of the level in ns, set from its size, block size and associativity
+  double hit_time;
+  double miss_penalty;
 };
 
 
@@ -46,22 +114,138 @@ class Cache{
   int set_bits;
   int tag_bits;
   int block_bits;
+  //width of a physical address, addresses are masked to it before the tag and set are taken out
+  int address_bits;
+  unsigned long long address_mask;
   int write_policy;
   int replace_policy;
-  //This pointer is used to point to the cache. Each element is a pointer to an array of block structures. Each element represents a set. 
-  struct block** set_array;
-  //counters for the sets needed for LFU
+  //set for victim caches, which do not fetch from the next level
+  int is_victim;
+  //one allocation from arena.h that holds every array below, including the ordered LRFU state
+  void* storage;
+  size_t storage_size;
+  //tags of every block, set after set, tag_bytes wide each, 4 when tag_bits is at most 32 and 8 otherwise. Each
+  //set takes tag_stride entries, which is the associativity rounded up to simd_ways, the tags of a full SIMD
+  //register, so every set starts aligned, the extra entries are never valid
+  void* tags;
+  int tag_bytes;
+  int tag_stride;
+  int simd_ways;
+  //valid and dirty bits of every block, each set takes mask_words 64 bit words
+  uint64_t* valid_bits;
+  uint64_t* dirty_bits;
+  int mask_words;
+  //replacement policy metadata of every block, indexed the same way as the tags. ages and the counters of
+  //the sets are only allocated for LFU, and CRF and last_time_stamp for LRFU, they are NULL for other policies
+  int* ages;
+  double* CRF;
+  int64_t* last_time_stamp;
   uint32_t* set_counters;
   //pointer to a Cache class instance, specifically the cache directly underneath the Cache level that this variable is in.
   Cache* next_level;
   Cache* victim;
- public:
+  //helper functions to get at the fields of a block
+  inline int blk(int set, int way){ return set*tag_stride+way; }
+  inline uint64_t tag_of(int set, int way){
+    if(tag_bytes==4) return ((uint32_t*)tags)[blk(set,way)];
+    return ((uint64_t*)tags)[blk(set,way)];
+  }
+  inline int is_valid(int set, int way){ return (int)((valid_bits[set*mask_words+(way>>6)]>>(way&63))&1); }
+  inline int is_dirty(int set, int way){ return (int)((dirty_bits[set*mask_words+(way>>6)]>>(way&63))&1); }
+  inline void set_valid(int set, int way){ valid_bits[set*mask_words+(way>>6)]|=1ULL<<(way&63); }
+  inline void set_dirty(int set, int way, int dirty){
+    uint64_t bit=1ULL<<(way&63);
+    if(dirty) dirty_bits[set*mask_words+(way>>6)]|=bit;
+    else dirty_bits[set*mask_words+(way>>6)]&=~bit;
+  }
+  //returns the first invalid way in the set, or -1 if the set is full
+  int find_invalid(int set);
+  //index from tag to way of a large fully associative cache, such as the victim cache, NULL for other caches
+  BlockMap* fa_index;
+  //recency list of every set of an LRU cache, NULL for other policies. The ways of a set are linked through
+  //their blocks, and the head of a set is its most recently used way
+  uint32_t* lru_prev;
+  uint32_t* lru_next;
+  uint32_t* lru_head;
+  uint32_t* lru_tail;
+  void lru_touch(int set, int way, int linked);
+  void lru_unlink(int set, int way);
+  //pseudo-LRU bits of every set, plru_words 64 bit words each, NULL for other policies. Tree PLRU keeps the nodes
+  //of a binary tree over the associativity rounded up to 2^plru_levels ways, node 1 is the root and the bit of a
+  //node points to the half that was used less recently. Bit PLRU keeps one bit per way that is set when the way
+  //is used, and when every bit would be set the others are cleared
+  uint64_t* plru_bits;
+  int plru_words;
+  int plru_levels;
+  void tree_touch(int set, int way);
+  int tree_victim(int set);
+  void bit_touch(int set, int way);
+  int bit_victim(int set);
+  //RRPV of every block as two bitmasks, the low and the high bit, each mask_words words per set, NULL for the
+  //policies that are not RRIP. DRRIP counts the misses of its leader sets in rrip_psel, and sets whose index
+  //is 0 modulo rrip_stride lead for SRRIP, the ones at rrip_stride/2 for BRRIP
+  uint64_t* rrip_low;
+  uint64_t* rrip_high;
+  int rrip_psel;
+  int rrip_stride;
+  //BRRIP insertions since the last long one
+  uint32_t rrip_bimodal;
+  void rrip_set(int set, int way, int value);
+  int rrip_victim(int set);
+  void rrip_insert(int set, int way, int policy);
+  //changes the tag of a block, keeping the index up to date
+  inline void write_tag(int set, int way, uint64_t tag){
+    if(fa_index!=NULL){
+      if(is_valid(set,way)) fa_index->erase(tag_of(set,way));
+      fa_index->insert(tag,way);
+    }
+    if(tag_bytes==4) ((uint32_t*)tags)[blk(set,way)]=(uint32_t)tag;
+    else ((uint64_t*)tags)[blk(set,way)]=tag;
+  }
+  //empties a block, moves a block out of the victim cache in to an empty way, and finds the way that holds an address
+  void clear_block(int set, int way);
+  void take_from_victim(int set, int way, int victim_index);
+  int find_block(unsigned long long address, int* set);
+  template<int VIC> inline int victim_role(){ return VIC==POLICY_DYNAMIC ? is_victim : VIC; }
+  //LRFU decay factors 0.5^(lambda*d) for the time differences d below decay_size, and the first d whose factor is 0
+  double* decay_table;
+  int64_t decay_size;
+  int64_t decay_zero;
+  inline double decay(int64_t d){ return d<decay_size ? decay_table[d] : (d>=decay_zero ? 0.0 : pow(0.5,(double)d*lambda)); }
+  //ordered LRFU state, only kept for high associativity sets. Every block has a key, log2(CRF)+lambda*(last_time_stamp-lrfu_ref),
+  //which orders the blocks by their decayed CRF at any time. Each set keeps a min heap of its blocks on the key and a list
+  //of them in order of last access, and blocks whose decayed CRF has reached exactly 0 are moved to a bitmask
+  double* lrfu_key;
+  int64_t lrfu_ref;
+  uint16_t* lrfu_heap;
+  uint16_t* lrfu_pos;
+  uint16_t* lrfu_heap_size;
+  uint16_t* lrfu_prev;
+  uint16_t* lrfu_next;
+  uint16_t* lrfu_head;
+  uint16_t* lrfu_tail;
+  uint64_t* lrfu_zero;
+  uint16_t* lrfu_stack;
+  //returns 1 if the sets are kept ordered, which only takes lambda and the associativity to decide
+  int lrfu_orders_sets();
+  void lrfu_init();
+  void lrfu_free();
+  void lrfu_touch(int set, int way);
+  int lrfu_victim(int set);
+  void lrfu_heap_remove(int set, int way);
+  void lrfu_sift(int set, int position);
+  void lrfu_rebase();
   //counter for vicitm cache swaps
-  int swaps;
+  uint64_t swaps;
   //counter to count reads and writes
-  int global_counter;
+  int64_t global_counter;
   //flag it indicate swap occuring
   int swap;
+  //block of the last hit of a warm-up and where it is, warm_way is -1 when there is none, see warm. Replacing or
+  //clearing any block forgets it
+  unsigned long long warm_block;
+  int warm_set;
+  int warm_way;
   //variable to hold lambda value
   double lambda;
   //variables that are used to calculate statistics about the cache
@@ -70,28 +254,102 @@ class Cache{
   float miss_penalty;
   float hit_time;
   char read_or_write;
-  int num_reads;
-  int num_writes;
-  int write_miss;
-  int read_miss;
-  int write_backs;
-  int mem_traffic;
-  char* cache_name;
-  //functions that are used to implement the replace and write policies. 
-  Cache(int blocksize, int size, int ass,double  rep_policy, int wr_policy, Cache* next_cache, int level,char* name, Cache* victim_c);
-  void LRU_update(int tag, int set, int hit);
-  void update_Print_LRU(int tag, int set, int hit);
-  void LFU_update(int tag, int set, int hit);
-  void LRFU_update(int tag, int set, int hit);
-  void LRU_replace(int tag, int set, unsigned long long address,int victim_index);
-  void LFU_replace(int tag, int  set, unsigned long long address,int victim_index);
-  void LRFU_replace(int tag, int  set, unsigned long long address,int victim_index);
-  //funciton that inputs a address to the cache
-  void cache_in(unsigned long long address, char r_or_w);
+  //64 bit counters, a long trace runs past 2^31 accesses
+  uint64_t num_reads;
+  uint64_t num_writes;
+  uint64_t write_miss;
+  uint64_t read_miss;
+  uint64_t write_backs;
+  uint64_t mem_traffic;
+ protected:
+  //body of cache_in, specialized on the replacement policy, write policy and victim role
+  template<int REP, int WR, int VIC> void access(unsigned long long address, char r_or_w);
+  template<int REP, int WR, int VIC> void access_batch(const unsigned long long* addresses, const char* ops, size_t count);
+  //body of cache_warm, access without the counters
+  template<int REP, int WR, int VIC> void warm(unsigned long long address, char r_or_w);
+  //dispatch to the update and replace functions of the replacement policy
+  template<int REP> void update(uint64_t tag, int set, int hit);
+  template<int REP, int VIC> void replace(uint64_t tag, int set, unsigned long long address, int victim_index);
+  //sets the counters of this cache to the totals of the caches it is made of, and takes their latencies and write
+  //policy, for a cache split into shards, see shard.h
+  void sum_counters(Cache** parts, int count);
+ public:
+  const char* cache_name;
+  //sorts the misses of this level into the three Cs when it is not NULL, see classify.h
+  MissClassifier* classifier;
+  //functions that are used to implement the replace and write policies. A cache built with shards greater than 1
+  //is one shard of a cache of size, it holds 1/shards of its sets and is given addresses with the shard bits of the
+  //set index taken out, see shard.h, its latencies are the ones of the whole cache
+  Cache(int blocksize, int size, int ass,double  rep_policy, int wr_policy, Cache* next_cache, int level,const char* name, Cache* victim_c, int addr_bits=CACHE_ADDRESS_BITS, int shards=1);
+  virtual ~Cache();
+  void LRU_update(uint64_t tag, int set, int hit);
+  void LFU_update(uint64_t tag, int set, int hit);
+  void LRFU_update(uint64_t tag, int set, int hit);
+  //also replaces for the pseudo-LRU and RRIP policies, which only pick the victim and record the new block differently
+  template<int REP, int VIC> void LRU_replace(uint64_t tag, int set, unsigned long long address,int victim_index);
+  template<int VIC> void LFU_replace(uint64_t tag, int  set, unsigned long long address,int victim_index);
+  template<int VIC> void LRFU_replace(uint64_t tag, int  set, unsigned long long address,int victim_index);
+  //funciton that inputs a address to the cache, checks the policies at run time unless the cache came from make_cache
+  virtual void cache_in(unsigned long long address, char r_or_w);
+  //runs count accesses in a row, loading the sets of the ones CACHE_PREFETCH ahead, for a level that is fed
+  //many accesses at once, like the L2 draining a miss queue
+  virtual void cache_in_batch(const unsigned long long* addresses, const char* ops, size_t count);
+  //inputs an address during a warm-up, changing the blocks, the replacement state and the LRFU clock exactly as
+  //cache_in does, without counting the access, its misses or a swap. The classifier is warmed up with it, but
+  //counts nothing. The requests it sends to the next level go through its cache_in, so that level counts them,
+  //and classifies them, until clear_stats
+  virtual void cache_warm(unsigned long long address, char r_or_w);
   //function to check to see if there is a hit on an address
-  int hit_or_miss(int tag, int set);
+  int hit_or_miss(uint64_t tag, int set);
   //wrapper function that calls cache_in for the next level of cache
   void issue_to_next(unsigned long long address, char read_or_w);
-  //reports out the statistics of the cache level, eg. miss rate, average access time
-  void report();
+  //attaches a miss classifier to this level, with a reuse distance histogram if reuse_histogram is 1
+  void enable_classifier(int reuse_histogram);
+  //calculates the final statistics of the cache level, eg. miss rate, average access time
+  virtual void calculate_stats();
+  //fills in the statistics of the cache level so far, calculating them first
+  void stats(struct cache_stats* out);
+  //sets the counters of the cache level back to 0, for the end of a warm-up, the blocks are left as they are
+  virtual void clear_stats();
+  //starts loading the tags of the set an address maps to, so an access to it a little later does not wait on memory
+  inline void prefetch(unsigned long long address){
+    int set=(int)(((address&address_mask)>>block_bits)&((1ULL<<set_bits)-1));
+    __builtin_prefetch((char*)tags+(size_t)blk(set,0)*tag_bytes);
+    __builtin_prefetch(&valid_bits[set*mask_words]);
+  }
+  //calculates the statistics of the cache level and writes its contents to a dump, see contents.h
+  virtual void report(ContentsDump* out);
+  //writes the blocks of one set as report does, numbered as label
+  void dump_set(ContentsDump* out, int set, int label);
+  //sets the number of accesses so far, which LRFU takes its time stamps from, for a shard that only sees some of them
+  inline void set_clock(int64_t accesses){ global_counter=accesses; }
+  //coherence actions used by the multicore mode, see multicore.h, each one looks in the victim cache too.
+  //state_of returns 0 when the block of the address is not here, 1 when it is clean and 2 when it is dirty,
+  //invalidate drops the block and returns the state it had, downgrade cleans it and returns 1 if it was dirty
+  int state_of(unsigned long long address);
+  int invalidate(unsigned long long address);
+  int downgrade(unsigned long long address);
+  //writes the state of the cache to a checkpoint, see checkpoint.h, returns 0 on failure
+  int save_checkpoint(FILE* file);
+  //restores the state from a checkpoint in memory, returns the bytes it used, or 0 if it was saved from a different cache
+  size_t restore_checkpoint(const char* data, size_t size);
 };
+
+//reads the replacement argument from the command line, a number, or lru, lfu, tree_plru, bit_plru, srrip, brrip
+//or drrip in any case
+double replacement_of(const char* arg);
+//maps the replacement argument to a replacement policy, 2 is LRU, 3 is LFU, the REPLACEMENT values above are the
+//pseudo-LRU and RRIP policies and anything else is the lambda of LRFU
+int replace_policy_of(double rep_policy);
+//name of the replacement argument of a policy on the command line, NULL for LRFU
+const char* replacement_arg_name(int policy);
+//replacement argument of the L2 cache for the one of the L1, the L2 uses LRU when the L1 uses LRFU
+double l2_replacement(double rep_policy);
+//name of a replacement policy
+const char* replace_policy_name(int policy);
+
+//builds a cache whose cache_in is specialized for its replacement policy, write policy and victim role,
+//takes the same arguments as the Cache constructor
+Cache* make_cache(int blocksize, int size, int ass,double  rep_policy, int wr_policy, Cache* next_cache, int level,const char* name, Cache* victim_c, int addr_bits=CACHE_ADDRESS_BITS, int shards=1);
+
+#endif
@@ -0,0 +1,153 @@
+/**************************************************************************************************************************
+
+Filename: checkpoint.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the functions of the cache and hierarchy classes that save and restore
+checkpoints, in the format described in checkpoint.h. The tag index of a large fully associative cache is not
+saved, it is rebuilt from the restored tags. Everything else a cache keeps per block or set is in its storage, so
+a section is the storage written out in one piece. The LRFU decay table only depends on lambda, so it is not saved
+either.
+
+****************************************************************************************************************************/
+
+#include "checkpoint.h"
+#include "cache.h"
+#include "hierarchy.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+int Cache::save_checkpoint(FILE* file){
+  struct cache_checkpoint record;
+  memset(&record,0,sizeof(record));
+  record.num_sets=num_sets;
+  if(storage!=NULL){
+    record.assoc=assoc;
+    record.tag_stride=tag_stride;
+    record.replace_policy=replace_policy;
+  }
+  record.bytes=storage!=NULL ? storage_size : 0;
+  record.global_counter=global_counter;
+  record.lrfu_ref=lrfu_key!=NULL ? lrfu_ref : 0;
+  record.swaps=swaps;
+  record.num_reads=num_reads;
+  record.num_writes=num_writes;
+  record.write_miss=write_miss;
+  record.read_miss=read_miss;
+  record.write_backs=write_backs;
+  record.rrip_psel=rrip_psel;
+  record.rrip_bimodal=rrip_bimodal;
+  if(fwrite(&record,sizeof(record),1,file)!=1) return 0;
+  if(record.bytes>0 && fwrite(storage,1,storage_size,file)!=storage_size) return 0;
+  return 1;
+}
+
+
+
+size_t Cache::restore_checkpoint(const char* data, size_t size){
+  struct cache_checkpoint record;
+  size_t bytes=storage!=NULL ? storage_size : 0;
+  if(size<sizeof(record)) return 0;
+  memcpy(&record,data,sizeof(record));
+  //the layout has to be the same as this cache
+  if(record.num_sets!=num_sets) return 0;
+  if(storage!=NULL && (record.assoc!=assoc || record.tag_stride!=tag_stride || record.replace_policy!=replace_policy)) return 0;
+  if(record.bytes!=bytes || size-sizeof(record)<bytes) return 0;
+  if(bytes>0) memcpy(storage,data+sizeof(record),bytes);
+  global_counter=record.global_counter;
+  if(lrfu_key!=NULL) lrfu_ref=record.lrfu_ref;
+  swaps=record.swaps;
+  num_reads=record.num_reads;
+  num_writes=record.num_writes;
+  write_miss=record.write_miss;
+  read_miss=record.read_miss;
+  write_backs=record.write_backs;
+  rrip_psel=record.rrip_psel;
+  rrip_bimodal=record.rrip_bimodal;
+  warm_way=-1;
+  //rebuild the tag index from the blocks that are valid
+  if(fa_index!=NULL){
+    fa_index->clear();
+    for(int way=0;way<assoc;way++){
+      if(is_valid(0,way)) fa_index->insert(tag_of(0,way),way);
+    }
+  }
+  return sizeof(record)+bytes;
+}
+
+
+
+int Hierarchy::save_checkpoint(const char* path){
+  struct checkpoint_header header;
+  Cache* levels[CHECKPOINT_LEVELS]={L1,victim,L2};
+  FILE* file;
+  int ok;
+  //the blocks of a sharded level are spread over its shards
+  if(l1_shards!=NULL || l2_shards!=NULL) return 0;
+  file=fopen(path,"wb");
+  if(file==NULL) return 0;
+  drain();
+  memset(&header,0,sizeof(header));
+  memcpy(header.magic,CHECKPOINT_MAGIC,CHECKPOINT_MAGIC_LEN);
+  header.config=config;
+  ok=fwrite(&header,sizeof(header),1,file)==1;
+  for(int i=0;i<CHECKPOINT_LEVELS && ok;i++) ok=levels[i]->save_checkpoint(file);
+  if(fclose(file)!=0) ok=0;
+  return ok;
+}
+
+
+
+int Hierarchy::restore_checkpoint(const char* path){
+  struct checkpoint_header header;
+  Cache* levels[CHECKPOINT_LEVELS]={L1,victim,L2};
+  struct stat info;
+  const char* data;
+  void* map;
+  size_t map_size,size,used;
+  int ok=1;
+  int fd;
+  if(l1_shards!=NULL || l2_shards!=NULL) return 0;
+  //the L2 is written below, so its thread must not be in the middle of a request
+  drain();
+  fd=open(path,O_RDONLY);
+  if(fd<0) return 0;
+  if(fstat(fd,&info)!=0 || (size_t)info.st_size<sizeof(header)){
+    close(fd);
+    return 0;
+  }
+  map_size=info.st_size;
+  size=map_size;
+  map=mmap(NULL,map_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(map==MAP_FAILED) return 0;
+  madvise(map,map_size,MADV_SEQUENTIAL);
+  data=(const char*)map;
+  memcpy(&header,data,sizeof(header));
+  //the checkpoint has to come from the same hierarchy, sampled or not
+  if(memcmp(header.magic,CHECKPOINT_MAGIC,CHECKPOINT_MAGIC_LEN)!=0 || header.config.block_size!=config.block_size
+     || header.config.l1_size!=config.l1_size || header.config.l1_assoc!=config.l1_assoc || header.config.vc_size!=config.vc_size
+     || header.config.l2_size!=config.l2_size || header.config.l2_assoc!=config.l2_assoc
+     || header.config.replacement!=config.replacement || header.config.address_bits!=config.address_bits) ok=0;
+  data+=sizeof(header);
+  size-=sizeof(header);
+  for(int i=0;i<CHECKPOINT_LEVELS && ok;i++){
+    used=levels[i]->restore_checkpoint(data,size);
+    if(used==0) ok=0;
+    data+=used;
+    size-=used;
+  }
+  munmap(map,map_size);
+  //a sampled hierarchy only counts what happens after the checkpoint
+  if(ok) counters(sample_counters);
+  return ok;
+}
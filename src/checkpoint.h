@@ -0,0 +1,61 @@
+/**************************************************************************************************************
+
+Filename:     checkpoint.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file describes the checkpoint file format. A checkpoint holds the whole state of a hierarchy,
+so a later run can start from warm caches instead of replaying the warm-up accesses again. It starts with a
+header that holds the configuration the hierarchy was built with, followed by one section for the L1, the
+victim and the L2 cache, in that order. A section is a fixed size record of the counters of the cache, followed
+by the raw bytes of its block storage exactly as it is laid out in memory, with the tags at the width the cache
+stores them and the metadata of its replacement policy, including the ordered LRFU state when it has it.
+
+Restoring maps the file into memory and copies the storage straight into the caches, so it takes about as
+long as reading the file. The arrays are written as they are in memory, so a checkpoint can only be restored
+into the same configuration, by a build with the same SIMD width.
+
+*****************************************************************************************************************/
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "hierarchy.h"
+#include <stdint.h>
+
+//magic string at the start of every checkpoint
+#define CHECKPOINT_MAGIC "CSIMCKP6"
+#define CHECKPOINT_MAGIC_LEN 8
+//number of cache sections, L1, victim and L2
+#define CHECKPOINT_LEVELS 3
+
+//header at the start of every checkpoint
+struct checkpoint_header{
+  char magic[CHECKPOINT_MAGIC_LEN];
+  struct hierarchy_config config;
+};
+
+//counters and layout of one cache, followed by bytes of array data
+struct cache_checkpoint{
+  int32_t num_sets;
+  int32_t assoc;
+  int32_t tag_stride;
+  int32_t replace_policy;
+  uint64_t bytes;
+  int64_t global_counter;
+  int64_t lrfu_ref;
+  uint64_t swaps;
+  uint64_t num_reads;
+  uint64_t num_writes;
+  uint64_t write_miss;
+  uint64_t read_miss;
+  uint64_t write_backs;
+  int32_t rrip_psel;
+  uint32_t rrip_bimodal;
+};
+
+#endif
@@ -0,0 +1,280 @@
+/**************************************************************************************************************************
+
+Filename: classify.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the miss classifier declared in classify.h.
+The reuse histogram is printed and written in power of two buckets, 0, 1, 2-3, 4-7 and so on, with the first
+accesses to a block in a bucket of their own.
+
+****************************************************************************************************************************/
+
+#include "classify.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+MissClassifier::MissClassifier(int bits, int sets, uint64_t blocks, int reuse_histogram){
+  block_bits=bits;
+  num_sets=sets;
+  capacity=blocks>0xFFFFFFF0ULL ? 0xFFFFFFF0U : (uint32_t)blocks;
+  if(capacity<1) capacity=1;
+  used=0;
+  head=SHADOW_NONE;
+  tail=SHADOW_NONE;
+  //a power of two number of entries, at least four per block
+  table_shift=64;
+  while(table_shift>32 && (1ULL<<(64-table_shift))<4ULL*capacity) table_shift--;
+  table_mask=((size_t)1<<(64-table_shift))-1;
+  table_used=0;
+  table_limit=(table_mask+1)/2;
+  table=(struct shadow_entry*)arena_alloc((table_mask+1)*sizeof(struct shadow_entry));
+  for(size_t i=0;i<=table_mask;i++) table[i].block=BLOCK_MAP_EMPTY;
+  touched=new BlockMap(64);
+  last_page=NULL;
+  last_page_number=0;
+  slots=(struct shadow_slot*)malloc((size_t)capacity*sizeof(struct shadow_slot));
+  set_accesses=(uint64_t*)calloc(num_sets,sizeof(uint64_t));
+  set_misses=(uint64_t*)calloc(num_sets,sizeof(uint64_t));
+  //one set, so the distances are the ones of a fully associative cache
+  reuse=reuse_histogram ? new StackDistance(1<<block_bits,1) : NULL;
+  accesses=0;
+  misses=0;
+  compulsory=0;
+  capacity_misses=0;
+  conflict=0;
+}
+
+
+
+MissClassifier::~MissClassifier(){
+  arena_free(table,(table_mask+1)*sizeof(struct shadow_entry));
+  for(size_t i=0;i<touched->slots();i++){
+    if(touched->key_at(i)!=BLOCK_MAP_EMPTY) arena_free((void*)touched->value_at(i),TOUCHED_PAGE_BYTES);
+  }
+  delete touched;
+  free(slots);
+  free(set_accesses);
+  free(set_misses);
+  if(reuse!=NULL) delete reuse;
+}
+
+
+
+void MissClassifier::unlink(uint32_t slot){
+  struct shadow_slot* s=&slots[slot];
+  if(s->prev!=SHADOW_NONE) slots[s->prev].next=s->next;
+  else head=s->next;
+  if(s->next!=SHADOW_NONE) slots[s->next].prev=s->prev;
+  else tail=s->prev;
+}
+
+
+
+void MissClassifier::push_front(uint32_t slot){
+  slots[slot].prev=SHADOW_NONE;
+  slots[slot].next=head;
+  if(head!=SHADOW_NONE) slots[head].prev=slot;
+  else tail=slot;
+  head=slot;
+}
+
+
+
+void MissClassifier::rebuild(){
+  for(size_t i=0;i<=table_mask;i++) table[i].block=BLOCK_MAP_EMPTY;
+  for(uint32_t slot=0;slot<used;slot++){
+    size_t i=entry_of(slots[slot].block);
+    if(slot+SHADOW_REBUILD_PREFETCH<used) __builtin_prefetch(&table[entry_of(slots[slot+SHADOW_REBUILD_PREFETCH].block)]);
+    while(table[i].block!=BLOCK_MAP_EMPTY) i=(i+1)&table_mask;
+    table[i].block=slots[slot].block;
+    table[i].slot=slot;
+  }
+  table_used=used;
+}
+
+
+
+//an entry is not taken out when its block is evicted, the block is only in the shadow while its slot still holds
+//it, and the stale entry is used again if the block comes back before the next rebuild
+int MissClassifier::shadow_access(uint64_t block){
+  size_t i=entry_of(block);
+  uint32_t slot;
+  while(table[i].block!=BLOCK_MAP_EMPTY && table[i].block!=block) i=(i+1)&table_mask;
+  if(table[i].block==block){
+    slot=(uint32_t)table[i].slot;
+    if(slots[slot].block==block){
+      //a hit in the shadow, move the block to the front
+      if(head!=slot){
+	unlink(slot);
+	push_front(slot);
+      }
+      return 1;
+    }
+  }
+  else if(table_used>=table_limit){
+    rebuild();
+    i=entry_of(block);
+    while(table[i].block!=BLOCK_MAP_EMPTY) i=(i+1)&table_mask;
+    table_used++;
+  }
+  else table_used++;
+  //bring the block in, taking the slot of the least recently used one when the shadow is full
+  if(used<capacity) slot=used++;
+  else{
+    slot=tail;
+    unlink(slot);
+  }
+  slots[slot].block=block;
+  push_front(slot);
+  table[i].block=block;
+  table[i].slot=slot;
+  return 0;
+}
+
+
+
+int MissClassifier::touch(uint64_t block){
+  uint64_t number=block>>TOUCHED_PAGE_BITS;
+  uint64_t* page=last_page;
+  uint64_t bit=1ULL<<(block&63);
+  size_t word=(size_t)((block&((1ULL<<TOUCHED_PAGE_BITS)-1))>>6);
+  if(page==NULL || number!=last_page_number){
+    uint64_t* entry=touched->find(number);
+    if(entry!=NULL) page=(uint64_t*)*entry;
+    else{
+      page=(uint64_t*)arena_alloc(TOUCHED_PAGE_BYTES);
+      touched->insert(number,(uint64_t)page);
+    }
+    last_page=page;
+    last_page_number=number;
+  }
+  uint64_t before=page[word];
+  page[word]=before|bit;
+  return (before&bit)!=0;
+}
+
+
+
+void MissClassifier::record(unsigned long long address, int set, int missed){
+  uint64_t block=address>>block_bits;
+  int in_shadow=shadow_access(block);
+  accesses++;
+  set_accesses[set]++;
+  if(reuse!=NULL) reuse->access(address);
+  if(!missed) return;
+  misses++;
+  set_misses[set]++;
+  if(in_shadow) conflict++;
+  else{
+    //whether a block was touched before hardly follows a pattern, so the counts are added to without a branch
+    int touched_before=touch(block);
+    capacity_misses+=touched_before;
+    compulsory+=1-touched_before;
+  }
+}
+
+
+
+//whether the level misses is not known yet during a warm-up, so every block is marked as touched
+void MissClassifier::warm(unsigned long long address){
+  shadow_access(address>>block_bits);
+  touch(address>>block_bits);
+  if(reuse!=NULL) reuse->access(address);
+}
+
+
+
+void MissClassifier::clear_counts(){
+  accesses=0;
+  misses=0;
+  compulsory=0;
+  capacity_misses=0;
+  conflict=0;
+  memset(set_accesses,0,num_sets*sizeof(uint64_t));
+  memset(set_misses,0,num_sets*sizeof(uint64_t));
+  if(reuse!=NULL) reuse->clear_counts();
+}
+
+
+
+//accesses with a reuse distance from low to high
+uint64_t MissClassifier::reuse_count(uint64_t low, uint64_t high){
+  uint64_t count=0;
+  for(uint64_t d=low;d<=high;d++) count+=reuse->distance_count(d);
+  return count;
+}
+
+
+
+//percentage of the misses, 0 when there are none
+static double share(uint64_t part, uint64_t whole){
+  return whole>0 ? 100.0*(double)part/(double)whole : 0.0;
+}
+
+
+
+void MissClassifier::print(const char* level){
+  printf("%s accesses:   %llu\n",level,(unsigned long long)accesses);
+  printf("%s misses:     %llu\n",level,(unsigned long long)misses);
+  printf("  compulsory:   %llu (%.2f%%)\n",(unsigned long long)compulsory,share(compulsory,misses));
+  printf("  capacity:     %llu (%.2f%%)\n",(unsigned long long)capacity_misses,share(capacity_misses,misses));
+  printf("  conflict:     %llu (%.2f%%)\n",(unsigned long long)conflict,share(conflict,misses));
+  if(reuse==NULL) return;
+  printf("  reuse distance histogram:\n");
+  printf("  %21s %14s\n","DISTANCE","ACCESSES");
+  for(uint64_t low=0;low<reuse->max_assoc();low=low==0 ? 1 : low*2){
+    uint64_t high=low==0 ? 0 : low*2-1;
+    uint64_t count=reuse_count(low,high);
+    printf("  %10llu - %8llu %14llu\n",(unsigned long long)low,(unsigned long long)high,(unsigned long long)count);
+  }
+  printf("  %21s %14llu\n","first use",(unsigned long long)reuse->get_cold_misses());
+}
+
+
+
+void MissClassifier::write_csv(FILE* file, const char* level){
+  fprintf(file,"%s,accesses,all,%llu\n",level,(unsigned long long)accesses);
+  fprintf(file,"%s,misses,all,%llu\n",level,(unsigned long long)misses);
+  fprintf(file,"%s,misses,compulsory,%llu\n",level,(unsigned long long)compulsory);
+  fprintf(file,"%s,misses,capacity,%llu\n",level,(unsigned long long)capacity_misses);
+  fprintf(file,"%s,misses,conflict,%llu\n",level,(unsigned long long)conflict);
+  if(reuse!=NULL){
+    for(uint64_t low=0;low<reuse->max_assoc();low=low==0 ? 1 : low*2){
+      uint64_t high=low==0 ? 0 : low*2-1;
+      uint64_t count=reuse_count(low,high);
+      fprintf(file,"%s,reuse,%llu-%llu,%llu\n",level,(unsigned long long)low,(unsigned long long)high,(unsigned long long)count);
+    }
+    fprintf(file,"%s,reuse,first,%llu\n",level,(unsigned long long)reuse->get_cold_misses());
+  }
+  for(int s=0;s<num_sets;s++) fprintf(file,"%s,set_accesses,%i,%llu\n",level,s,(unsigned long long)set_accesses[s]);
+  for(int s=0;s<num_sets;s++) fprintf(file,"%s,set_misses,%i,%llu\n",level,s,(unsigned long long)set_misses[s]);
+}
+
+
+
+void MissClassifier::write_json(FILE* file, const char* level){
+  fprintf(file,"{\"level\":\"%s\",\"accesses\":%llu,\"misses\":%llu,",level,(unsigned long long)accesses,(unsigned long long)misses);
+  fprintf(file,"\"compulsory\":%llu,\"capacity\":%llu,\"conflict\":%llu",(unsigned long long)compulsory,
+	  (unsigned long long)capacity_misses,(unsigned long long)conflict);
+  if(reuse!=NULL){
+    fprintf(file,",\"reuse\":[");
+    for(uint64_t low=0;low<reuse->max_assoc();low=low==0 ? 1 : low*2){
+      uint64_t high=low==0 ? 0 : low*2-1;
+      uint64_t count=reuse_count(low,high);
+      fprintf(file,"%s{\"min\":%llu,\"max\":%llu,\"count\":%llu}",low==0 ? "" : ",",(unsigned long long)low,
+	      (unsigned long long)high,(unsigned long long)count);
+    }
+    fprintf(file,"],\"first_use\":%llu",(unsigned long long)reuse->get_cold_misses());
+  }
+  fprintf(file,",\"set_accesses\":[");
+  for(int s=0;s<num_sets;s++) fprintf(file,"%s%llu",s==0 ? "" : ",",(unsigned long long)set_accesses[s]);
+  fprintf(file,"],\"set_misses\":[");
+  for(int s=0;s<num_sets;s++) fprintf(file,"%s%llu",s==0 ? "" : ",",(unsigned long long)set_misses[s]);
+  fprintf(file,"]}");
+}
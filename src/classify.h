@@ -0,0 +1,135 @@
+/**************************************************************************************************************
+
+Filename:     classify.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the miss classifier. A classifier can be attached to any cache
+level, and then it sees every access the level gets and sorts each miss into one of the three Cs:
+
+  compulsory  the first access to the block, no cache could have held it
+  capacity    a fully associative LRU cache of the same size would also have missed
+  conflict    a fully associative LRU cache of the same size would have hit, so the set mapping caused it
+
+The fully associative cache is a shadow that only keeps tags, in slots linked into a recency list, and an open
+addressing hash table from a block to its slot, with the block and the slot in one entry so a lookup touches one
+host cache line. The entry of an evicted block is left in place and is stale once its slot holds another block.
+When half the table is used it is emptied and the blocks the shadow holds are put back, so the table stays at
+four entries per block of the level, however large the footprint of the trace is, and it is looked at on every
+access. Whether a block was ever touched before is kept apart, in a bitmap of every block the level has missed
+on. It is split in pages that are only allocated once a block in them is touched, found through a small map. The
+pages come from arena.h, on huge pages and only backed by memory where they are written, so the bitmap takes
+about one bit per block of the footprint. A block the level hits on must have missed before, so the bitmap is
+only looked at when the level misses and the shadow does not hold the block, to tell compulsory from capacity
+misses.
+
+The classifier also counts the accesses and misses of every set, a heatmap of where the misses land, and
+when asked to it keeps a histogram of reuse distances, the number of distinct blocks used between two
+accesses to the same block, with the stack distance engine of stack_distance.h. The histogram costs a
+Fenwick tree update per access, so it is optional. Everything can be written out as CSV or JSON.
+
+*****************************************************************************************************************/
+#ifndef CLASSIFY_H
+#define CLASSIFY_H
+
+#include "block_map.h"
+#include "stack_distance.h"
+#include <stdint.h>
+#include <stdio.h>
+
+//end of the recency list of the shadow cache
+#define SHADOW_NONE 0xFFFFFFFFU
+//a page of the bitmap of touched blocks covers 1<<TOUCHED_PAGE_BITS blocks, one huge page of bits
+#define TOUCHED_PAGE_BITS 24
+#define TOUCHED_PAGE_BYTES (((size_t)1<<TOUCHED_PAGE_BITS)/8)
+//how many blocks ahead a rebuild of the shadow table starts loading the entry of a block
+#define SHADOW_REBUILD_PREFETCH 16
+
+//one block of the shadow cache, kept together so moving it in the recency list touches one host cache line
+struct shadow_slot{
+  uint64_t block;
+  uint32_t prev;
+  uint32_t next;
+};
+
+//one entry of the table of the shadow, an empty one has the block BLOCK_MAP_EMPTY
+struct shadow_entry{
+  uint64_t block;
+  uint64_t slot;
+};
+
+
+//Class that classifies the misses of one cache level
+class MissClassifier{
+ private:
+  int block_bits;
+  int num_sets;
+  //shadow fully associative LRU cache with as many blocks as the level, the table has four entries per block and
+  //holds at most table_limit of them, the ones of blocks still in the shadow and stale ones
+  struct shadow_entry* table;
+  size_t table_mask;
+  int table_shift;
+  size_t table_used;
+  size_t table_limit;
+  struct shadow_slot* slots;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t capacity;
+  uint32_t used;
+  //bitmap of every block the level has missed on, the map goes from the page number to the page
+  BlockMap* touched;
+  //the page touch used last and its number, a trace seldom goes out of one page
+  uint64_t* last_page;
+  uint64_t last_page_number;
+  //per set heatmap
+  uint64_t* set_accesses;
+  uint64_t* set_misses;
+  //reuse distances, NULL unless the histogram was asked for
+  StackDistance* reuse;
+  void unlink(uint32_t slot);
+  void push_front(uint32_t slot);
+  inline size_t entry_of(uint64_t block){ return (size_t)((block*0x9E3779B97F4A7C15ULL)>>table_shift); }
+  //empties the table and puts back the blocks the shadow holds, which drops the stale entries
+  void rebuild();
+  //returns 1 if the shadow holds the block, 0 if it does not, and then it brings the block in
+  int shadow_access(uint64_t block);
+  //returns 1 if the block was touched before, and marks it as touched
+  int touch(uint64_t block);
+  uint64_t reuse_count(uint64_t low, uint64_t high);
+ public:
+  uint64_t accesses;
+  uint64_t misses;
+  uint64_t compulsory;
+  uint64_t capacity_misses;
+  uint64_t conflict;
+  MissClassifier(int block_bits, int num_sets, uint64_t blocks, int reuse_histogram);
+  ~MissClassifier();
+  //starts loading the shadow entry and the word of the bitmap a record of the address will look at
+  inline void prefetch(unsigned long long address){
+    uint64_t block=address>>block_bits;
+    __builtin_prefetch(&table[entry_of(block)]);
+    if(last_page!=NULL && (block>>TOUCHED_PAGE_BITS)==last_page_number){
+      __builtin_prefetch(last_page+((block&((1ULL<<TOUCHED_PAGE_BITS)-1))>>6));
+    }
+  }
+  //records one access to the level, address already masked, missed is 1 if the level missed
+  void record(unsigned long long address, int set, int missed);
+  //records one access of a warm-up, it moves the shadow and the reuse distances on without counting anything,
+  //so the blocks of the warm-up are not compulsory misses after it
+  void warm(unsigned long long address);
+  //sets every count back to 0 at the end of a warm-up, the shadow and the blocks touched so far are kept
+  void clear_counts();
+  //prints the breakdown, and the reuse histogram when there is one
+  void print(const char* level);
+  //writes one line per value, level,metric,bucket,value
+  void write_csv(FILE* file, const char* level);
+  //writes one JSON object for the level
+  void write_json(FILE* file, const char* level);
+};
+
+#endif
@@ -0,0 +1,191 @@
+/**************************************************************************************************************************
+
+Filename: contents.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the contents dump declared in contents.h.
+Text goes to stdout through the same FILE as the rest of the report, so it comes out in the right place between
+the configuration and the results.
+
+****************************************************************************************************************************/
+
+#include "contents.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+//room a block needs at most in the text, a tag of up to 16 hex digits and the dirty flag
+#define CONTENTS_ROOM 64
+
+
+ContentsDump::ContentsDump(){
+  file=NULL;
+  compressed=NULL;
+  binary=0;
+  failed=0;
+  set=0;
+  memset(&level,0,sizeof(level));
+  level_offset=-1;
+  buffer=NULL;
+  used=0;
+}
+
+
+
+ContentsDump::~ContentsDump(){
+  if(compressed!=NULL) gzclose(compressed);
+  if(file!=NULL && file!=stdout) fclose(file);
+  free(buffer);
+}
+
+
+
+int ContentsDump::open(const char* path){
+  size_t length=path!=NULL ? strlen(path) : 0;
+  if(path==NULL) file=stdout;
+  else if(length>=3 && strcmp(path+length-3,".gz")==0){
+    compressed=gzopen(path,"wb1");
+    if(compressed==NULL) return 0;
+  }
+  else{
+    file=fopen(path,"wb");
+    if(file==NULL) return 0;
+    binary=length>=4 && strcmp(path+length-4,".bin")==0;
+  }
+  buffer=(char*)malloc(CONTENTS_BUFFER);
+  if(binary){
+    struct contents_header header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,CONTENTS_MAGIC,CONTENTS_MAGIC_LEN);
+    append(&header,sizeof(header));
+  }
+  return 1;
+}
+
+
+
+void ContentsDump::flush(){
+  if(used>0){
+    if(compressed!=NULL){
+      if(gzwrite(compressed,buffer,(unsigned)used)!=(int)used) failed=1;
+    }
+    else if(fwrite(buffer,1,used,file)!=used) failed=1;
+  }
+  used=0;
+}
+
+
+
+void ContentsDump::append(const void* data, size_t length){
+  if(used+length>CONTENTS_BUFFER) flush();
+  memcpy(buffer+used,data,length);
+  used+=length;
+}
+
+
+
+void ContentsDump::append_text(const char* text){
+  append(text,strlen(text));
+}
+
+
+
+//the callers leave room for the digits
+void ContentsDump::append_number(unsigned long long value, int base){
+  char digits[24];
+  int n=0;
+  do{
+    digits[n++]="0123456789ABCDEF"[value%base];
+    value/=base;
+  }while(value>0);
+  while(n>0) buffer[used++]=digits[--n];
+}
+
+
+
+void ContentsDump::finish_level(){
+  if(level_offset<0) return;
+  flush();
+  if(fseek(file,level_offset,SEEK_SET)!=0 || fwrite(&level,sizeof(level),1,file)!=1 || fseek(file,0,SEEK_END)!=0) failed=1;
+  level_offset=-1;
+}
+
+
+
+void ContentsDump::begin_level(const char* name, int sets, int ways){
+  if(binary){
+    finish_level();
+    flush();
+    level_offset=ftell(file);
+    memset(&level,0,sizeof(level));
+    strncpy(level.name,name,CONTENTS_NAME_LEN-1);
+    level.sets=(uint64_t)sets;
+    level.ways=(uint64_t)ways;
+    append(&level,sizeof(level));
+    return;
+  }
+  append_text("===== ");
+  append_text(name);
+  append_text(" contents =====\n");
+}
+
+
+
+void ContentsDump::begin_set(int label){
+  set=(uint32_t)label;
+  if(binary) return;
+  if(used+CONTENTS_ROOM>CONTENTS_BUFFER) flush();
+  append_text("set     ");
+  append_number((unsigned long long)label,10);
+  append_text(":   ");
+}
+
+
+
+void ContentsDump::add_block(int way, int valid, unsigned long long tag, int dirty){
+  if(binary){
+    struct contents_block block;
+    if(!valid) return;
+    memset(&block,0,sizeof(block));
+    block.tag=tag;
+    block.set=set;
+    block.way=(uint32_t)way;
+    block.dirty=(uint8_t)dirty;
+    append(&block,sizeof(block));
+    level.blocks++;
+    return;
+  }
+  if(used+CONTENTS_ROOM>CONTENTS_BUFFER) flush();
+  if(valid){
+    buffer[used++]=' ';
+    append_number(tag,16);
+    append_text(dirty ? "     D  " : "   ");
+  }
+  else append_text("  -   ");
+}
+
+
+
+void ContentsDump::end_set(){
+  if(!binary) append_text("\n");
+}
+
+
+
+int ContentsDump::close(){
+  if(binary) finish_level();
+  flush();
+  if(compressed!=NULL){
+    if(gzclose(compressed)!=Z_OK) failed=1;
+    compressed=NULL;
+  }
+  else if(file==stdout){
+    if(fflush(stdout)!=0) failed=1;
+  }
+  else if(file!=NULL && fclose(file)!=0) failed=1;
+  file=NULL;
+  return !failed;
+}
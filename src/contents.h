@@ -0,0 +1,102 @@
+/**************************************************************************************************************
+
+Filename:     contents.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the contents dump. A run only writes out the blocks every level
+holds at the end when it is asked to, a large L2 has hundreds of thousands of sets and printing them can take
+longer than simulating a short trace. The dump is put together in a buffer and written out when it fills, with
+the numbers formatted by hand instead of with printf.
+
+A dump to stdout, or to a file whose name ends in neither .bin nor .gz, is the text the simulator has always
+printed, one line per set with the tag of every valid block, D after the dirty ones and - for the empty ways:
+
+  ===== L1 contents =====
+  set     0:    3F2A     -    1B0     D
+
+A file whose name ends in .gz holds the same text compressed with gzip at its fastest level. A file whose name
+ends in .bin is binary, a header followed by every level, each one a level header and then a record for every
+valid block, in the order of the sets and ways. The number of records of a level is only known once it has been
+written, so its header is filled in then.
+
+*****************************************************************************************************************/
+#ifndef CONTENTS_H
+#define CONTENTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <zlib.h>
+
+//magic string at the start of every binary contents dump
+#define CONTENTS_MAGIC "CSIMCNT1"
+#define CONTENTS_MAGIC_LEN 8
+//bytes of a level name in a binary dump
+#define CONTENTS_NAME_LEN 16
+//bytes kept before they are written out
+#define CONTENTS_BUFFER (1<<16)
+
+//header at the start of every binary contents dump
+struct contents_header{
+  char magic[CONTENTS_MAGIC_LEN];
+};
+
+//header at the start of every level of a binary contents dump, it is followed by blocks records
+struct contents_level{
+  char name[CONTENTS_NAME_LEN];
+  uint64_t sets;
+  uint64_t ways;
+  uint64_t blocks;
+};
+
+//one valid block of a binary contents dump
+struct contents_block{
+  uint64_t tag;
+  uint32_t set;
+  uint32_t way;
+  uint8_t dirty;
+  uint8_t unused[7];
+};
+
+
+//Class that writes the contents of the levels of a hierarchy to stdout or a file
+class ContentsDump{
+ private:
+  FILE* file;
+  gzFile compressed;
+  int binary;
+  int failed;
+  //set being written, for the records of a binary dump, and the header of the level being written and where it is
+  uint32_t set;
+  struct contents_level level;
+  long level_offset;
+  char* buffer;
+  size_t used;
+  void append(const void* data, size_t length);
+  void append_text(const char* text);
+  void append_number(unsigned long long value, int base);
+  void flush();
+  //fills in the header of the level that was being written
+  void finish_level();
+ public:
+  ContentsDump();
+  ~ContentsDump();
+  //opens the file, or writes text to stdout when path is NULL, returns 0 if the file cannot be opened
+  int open(const char* path);
+  //starts a level, every set of it follows
+  void begin_level(const char* name, int sets, int ways);
+  //starts a set, every way of it follows, in order
+  void begin_set(int label);
+  void add_block(int way, int valid, unsigned long long tag, int dirty);
+  void end_set();
+  //writes out what is left and closes the file, returns 0 if anything failed to be written
+  int close();
+};
+
+#endif
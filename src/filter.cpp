@@ -0,0 +1,303 @@
+/**************************************************************************************************************************
+
+Filename: filter.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the filter and replay modes declared in filter.h.
+The filter builds the L1 and victim cache the way a hierarchy does, but with a stream writer in place of the
+miss queue, a disabled cache that packs every request it is sent and writes them out a batch at a time. The
+header is written last, once the number of requests and the statistics are known.
+A replay maps the miss stream and hands it to every L2 in batches with cache_in_batch, the same way a miss queue
+would. Each L2 only reads the mapped stream, so the configurations are split across threads without any
+synchronization until they are all done.
+
+****************************************************************************************************************************/
+
+#include "filter.h"
+#include "trace.h"
+#include "trace_stream.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+
+//A disabled cache that writes every request it is sent to a miss stream
+class StreamWriter : public Cache{
+ public:
+  FILE* file;
+  uint64_t* buffer;
+  size_t count;
+  //requests written so far, and set when a write failed
+  uint64_t written;
+  int failed;
+  StreamWriter(FILE* stream_file) : Cache(0,0,0,2,0,NULL,2,"Stream",NULL){
+    file=stream_file;
+    buffer=(uint64_t*)malloc(FILTER_BATCH*sizeof(uint64_t));
+    count=0;
+    written=0;
+    failed=0;
+  }
+  ~StreamWriter(){
+    free(buffer);
+  }
+  void cache_in(unsigned long long address, char r_or_w){
+    buffer[count++]=trace_pack(address,r_or_w);
+    if(count==FILTER_BATCH) flush();
+  }
+  void flush(){
+    if(count>0 && fwrite(buffer,sizeof(uint64_t),count,file)!=count) failed=1;
+    written+=count;
+    count=0;
+  }
+};
+
+
+
+static double seconds_since(const struct timeval* begin){
+  struct timeval end;
+  gettimeofday(&end,NULL);
+  return (double)(end.tv_sec-begin->tv_sec)+(double)(end.tv_usec-begin->tv_usec)/1000000.0;
+}
+
+
+
+//prints the L1 side of a configuration, the L2 is left out
+static void print_l1_config(const struct hierarchy_config* config){
+  printf("L1_BLOCKSIZE:   %i\n",config->block_size);
+  printf("L1_SIZE:        %i\n",config->l1_size);
+  printf("L1_ASSOC:       %i\n",config->l1_assoc);
+  printf("Victim_Cache_SIZE:    %i \n",config->vc_size);
+  if(replace_policy_of(config->replacement)==REPLACE_LRFU) printf("Replacement Policy:      LRFU\nlambda: %g\n",config->replacement);
+  else printf("Replacement Policy:    %s\n",replace_policy_name(replace_policy_of(config->replacement)));
+}
+
+
+
+int run_filter(const struct hierarchy_config* config, const char* trace_path, const char* stream_path){
+  struct filter_header header;
+  TraceStream trace;
+  const uint64_t* batch;
+  size_t count;
+  uint64_t accesses=0;
+  struct timeval begin;
+  FILE* file;
+  int ok;
+  if(!trace.open(trace_path)){
+    printf("Error opening file\n");
+    return 1;
+  }
+  file=fopen(stream_path,"wb");
+  if(file==NULL){
+    printf("Error opening %s\n",stream_path);
+    return 1;
+  }
+  //the header is filled in at the end, leave room for it
+  memset(&header,0,sizeof(header));
+  ok=fwrite(&header,sizeof(header),1,file)==1;
+  StreamWriter writer(file);
+  //the same L1 and victim cache a hierarchy builds, sending their requests to the writer instead of the L2
+  Cache* victim=make_cache(config->block_size,config->vc_size,config->block_size>0 ? config->vc_size/config->block_size : 0,2,0,&writer,1,"Victim",NULL,config->address_bits);
+  Cache* victim_cache=config->vc_size>0 ? victim : NULL;
+  Cache* L1=make_cache(config->block_size,config->l1_size,config->l1_assoc,config->replacement,0,&writer,1,"L1",victim_cache,config->address_bits);
+
+  printf("===== Filter configuration =====\n");
+  print_l1_config(config);
+  printf("trace_file:      %s\n",trace_path);
+  printf("stream_file:     %s\n",stream_path);
+  printf("================================\n\n");
+
+  gettimeofday(&begin,NULL);
+  while((count=trace.next_batch(&batch))>0){
+    for(size_t i=0;i<count;i++) L1->cache_in(trace_address(batch[i]),trace_op(batch[i]));
+    accesses+=count;
+  }
+  trace.close();
+  writer.flush();
+  memcpy(header.magic,FILTER_MAGIC,FILTER_MAGIC_LEN);
+  header.config=*config;
+  header.config.l2_size=0;
+  header.config.l2_assoc=0;
+  header.config.sample_fraction=0;
+  header.config.shards=0;
+  L1->stats(&header.l1);
+  if(victim_cache!=NULL) victim->stats(&header.victim);
+  header.num_records=writer.written;
+  if(ok && !writer.failed && fseek(file,0,SEEK_SET)==0) ok=fwrite(&header,sizeof(header),1,file)==1;
+  else ok=0;
+  if(fclose(file)!=0) ok=0;
+  delete L1;
+  delete victim;
+  if(!ok){
+    printf("Error writing %s\n",stream_path);
+    return 1;
+  }
+  printf("L1 accesses:        %llu\n",(unsigned long long)accesses);
+  printf("L1 miss rate:       %.4f\n",header.l1.miss_rate);
+  printf("requests written:   %llu (%.2f%% of the accesses)\n",(unsigned long long)header.num_records,
+	 accesses>0 ? 100.0*(double)header.num_records/(double)accesses : 0.0);
+  printf("\nfiltered %llu accesses in %.3f s\n",(unsigned long long)accesses,seconds_since(&begin));
+  return 0;
+}
+
+
+
+//what each replay thread is handed, it runs every threads-th L2 starting at id over the whole stream
+struct replay_worker{
+  Cache** caches;
+  int count;
+  int threads;
+  int id;
+  const uint64_t* records;
+  uint64_t num_records;
+};
+
+
+
+static void* replay_worker_main(void* arg){
+  struct replay_worker* worker=(struct replay_worker*)arg;
+  unsigned long long* addresses=(unsigned long long*)malloc(FILTER_BATCH*sizeof(unsigned long long));
+  char* ops=(char*)malloc(FILTER_BATCH);
+  for(int c=worker->id;c<worker->count;c+=worker->threads){
+    for(uint64_t start=0;start<worker->num_records;start+=FILTER_BATCH){
+      size_t part=worker->num_records-start<FILTER_BATCH ? (size_t)(worker->num_records-start) : FILTER_BATCH;
+      for(size_t i=0;i<part;i++){
+	addresses[i]=trace_address(worker->records[start+i]);
+	ops[i]=trace_op(worker->records[start+i]);
+      }
+      worker->caches[c]->cache_in_batch(addresses,ops,part);
+    }
+  }
+  free(addresses);
+  free(ops);
+  return NULL;
+}
+
+
+
+int run_replay(const char* stream_path, const int* l2_sizes, const int* l2_assocs, int count, int threads,
+	       int contents, const char* contents_path, const char* stats_path){
+  struct filter_header header;
+  struct stat info;
+  struct replay_worker workers[REPLAY_MAX];
+  pthread_t handles[REPLAY_MAX];
+  Cache* caches[REPLAY_MAX];
+  struct timeval begin;
+  size_t map_size;
+  void* map;
+  int started=0;
+  int fd;
+  if(count<1 || count>REPLAY_MAX){
+    printf("A replay takes 1 to %i L2 configurations\n",REPLAY_MAX);
+    return 1;
+  }
+  fd=open(stream_path,O_RDONLY);
+  if(fd<0){
+    printf("Error opening %s\n",stream_path);
+    return 1;
+  }
+  if(fstat(fd,&info)!=0 || (size_t)info.st_size<sizeof(header) || pread(fd,&header,sizeof(header),0)!=(ssize_t)sizeof(header)
+     || memcmp(header.magic,FILTER_MAGIC,FILTER_MAGIC_LEN)!=0){
+    close(fd);
+    printf("%s is not a miss stream\n",stream_path);
+    return 1;
+  }
+  map_size=info.st_size;
+  map=mmap(NULL,map_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(map==MAP_FAILED){
+    printf("Error opening %s\n",stream_path);
+    return 1;
+  }
+  //do not trust a count that runs past the end of the file
+  if(header.num_records>(map_size-sizeof(header))/sizeof(uint64_t)) header.num_records=(map_size-sizeof(header))/sizeof(uint64_t);
+  if(threads<=0) threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads<1) threads=1;
+  if(threads>count) threads=count;
+  //every L2 is built the way a hierarchy builds it
+  for(int c=0;c<count;c++){
+    caches[c]=make_cache(header.config.block_size,l2_sizes[c],l2_assocs[c],l2_replacement(header.config.replacement),0,NULL,2,"L2",NULL,header.config.address_bits);
+  }
+
+  printf("===== Replay configuration =====\n");
+  print_l1_config(&header.config);
+  printf("stream_file:     %s\n",stream_path);
+  printf("requests:        %llu\n",(unsigned long long)header.num_records);
+  if(count>1) printf("configurations:  %i\nthreads:         %i\n",count,threads);
+  printf("================================\n\n");
+
+  gettimeofday(&begin,NULL);
+  for(int i=0;i<threads;i++){
+    workers[i].caches=caches;
+    workers[i].count=count;
+    workers[i].threads=threads;
+    workers[i].id=i;
+    workers[i].records=(const uint64_t*)((const char*)map+sizeof(header));
+    workers[i].num_records=header.num_records;
+  }
+  //the calling thread runs the first worker, and the ones of any threads that could not be started
+  for(int i=1;i<threads;i++){
+    if(pthread_create(&handles[i],NULL,replay_worker_main,&workers[i])!=0) break;
+    started++;
+  }
+  replay_worker_main(&workers[0]);
+  for(int i=started+1;i<threads;i++) replay_worker_main(&workers[i]);
+  for(int i=1;i<=started;i++) pthread_join(handles[i],NULL);
+
+  //a single L2 is reported the same way a normal run reports the whole hierarchy, without the L1 contents
+  if(count==1){
+    struct hierarchy_stats all;
+    int ok=1;
+    memset(&all,0,sizeof(all));
+    all.l1=header.l1;
+    all.victim=header.victim;
+    if(contents){
+      ContentsDump dump;
+      if(dump.open(contents_path)){
+	caches[0]->report(&dump);
+	ok=dump.close();
+      }
+      else ok=0;
+      if(!ok) printf("Error writing %s\n",contents_path!=NULL ? contents_path : "the contents");
+    }
+    caches[0]->stats(&all.l2);
+    hierarchy_combine_stats(&all,1);
+    hierarchy_print_results(&all,1);
+    if(stats_path!=NULL && !hierarchy_write_stats(&all,1,stats_path)){
+      printf("Error writing %s\n",stats_path);
+      ok=0;
+    }
+    if(!ok){
+      for(int c=0;c<count;c++) delete caches[c];
+      munmap(map,map_size);
+      return 1;
+    }
+  }
+  else{
+    if(contents || stats_path!=NULL) printf("Only a replay of a single L2 can write out its contents or results\n\n");
+    printf("%4s %8s %5s | %9s %9s %9s %9s %10s %10s\n","#","L2_SIZE","L2_A","L1_MISS","L2_READS","L2_MISS","L2_WB","MEM_TRAF","AAT_NS");
+    for(int c=0;c<count;c++){
+      struct hierarchy_stats all;
+      memset(&all,0,sizeof(all));
+      all.l1=header.l1;
+      all.victim=header.victim;
+      caches[c]->stats(&all.l2);
+      hierarchy_combine_stats(&all,1);
+      printf("%4i %8i %5i | %9.4f %9llu %9.4f %9llu %10llu %10.4f\n",c+1,l2_sizes[c],l2_assocs[c],all.l1.miss_rate,
+	     (unsigned long long)all.l2.reads,all.l2.miss_rate,(unsigned long long)all.l2.write_backs,
+	     (unsigned long long)all.memory_traffic,(float)all.average_access_time);
+    }
+    printf("\nreplayed %llu requests for %i configurations in %.3f s\n",(unsigned long long)header.num_records,count,seconds_since(&begin));
+  }
+  for(int c=0;c<count;c++) delete caches[c];
+  munmap(map,map_size);
+  return 0;
+}
@@ -0,0 +1,58 @@
+/**************************************************************************************************************
+
+Filename:     filter.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the filter and replay modes of the simulator. An L1 and its
+victim cache behave the same whatever L2 is under them, so a sweep over L2 configurations does not need to
+simulate them again for every one. The filter mode runs a trace through an L1 and victim cache once and writes
+every fetch and write back they send to the next level, in the order they send them, to a miss stream. The
+replay mode runs a miss stream through one or more L2 caches, and gets exactly the results a full run of each
+whole hierarchy would.
+
+A miss stream starts with a header that holds the configuration of the L1 side, with the L2 size and
+associativity at 0, and the statistics the L1 and victim cache ended the run with, so a replay can print the
+results of the whole hierarchy. It is followed by one packed record per request, in the format of the records of
+a binary trace, see trace.h. Only the misses and write backs of the L1 are in it, so for most traces it is a
+small part of the trace.
+
+*****************************************************************************************************************/
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "hierarchy.h"
+#include <stdint.h>
+
+//magic string at the start of every miss stream
+#define FILTER_MAGIC "CSIMFLT2"
+#define FILTER_MAGIC_LEN 8
+//requests collected before they are written out, and handed to an L2 at once by a replay
+#define FILTER_BATCH 65536
+//most L2 configurations one replay runs
+#define REPLAY_MAX 256
+
+//header at the start of every miss stream
+struct filter_header{
+  char magic[FILTER_MAGIC_LEN];
+  struct hierarchy_config config;
+  struct cache_stats l1;
+  struct cache_stats victim;
+  uint64_t num_records;
+};
+
+//runs the L1 and victim cache of config on the trace and writes the requests they send to the L2 to stream_path
+int run_filter(const struct hierarchy_config* config, const char* trace_path, const char* stream_path);
+//runs a miss stream through an L2 of every size and associativity in l2_sizes and l2_assocs, threads of 0 uses
+//one thread per core. A single L2 is reported like a normal run, its contents are written out when contents is
+//set, to contents_path or to stdout when it is NULL, and its results to stats_path when it is not NULL. Several
+//L2 caches are printed in one table
+int run_replay(const char* stream_path, const int* l2_sizes, const int* l2_assocs, int count, int threads,
+	       int contents, const char* contents_path, const char* stats_path);
+
+#endif
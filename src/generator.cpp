@@ -0,0 +1,213 @@
+/**************************************************************************************************************************
+
+Filename: generator.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the workload generator declared in generator.h.
+Random numbers come from a xorshift64* generator seeded through splitmix64. Zipf ranks are drawn by rejection
+inversion, which takes a constant time per access and no table, so the footprint can be as large as wanted.
+
+****************************************************************************************************************************/
+
+#include "generator.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+int is_generator(const char* path){
+  return strncmp(path,GEN_PREFIX,GEN_PREFIX_LEN)==0;
+}
+
+
+
+//reads a size with an optional K, M or G after it
+static uint64_t parse_size(const char* value){
+  char* end;
+  uint64_t size=strtoull(value,&end,0);
+  if(*end=='K' || *end=='k') size<<=10;
+  else if(*end=='M' || *end=='m') size<<=20;
+  else if(*end=='G' || *end=='g') size<<=30;
+  return size;
+}
+
+
+
+static uint64_t gcd(uint64_t a, uint64_t b){
+  while(b!=0){
+    uint64_t t=a%b;
+    a=b;
+    b=t;
+  }
+  return a;
+}
+
+
+
+int Generator::open(const char* spec){
+  static const char* patterns[]={"strided","stream","zipf","hotcold","phases"};
+  char name[1024];
+  char* field;
+  char* saved;
+  //defaults
+  memset(&config,0,sizeof(config));
+  config.pattern=-1;
+  config.accesses=10000000;
+  config.seed=1;
+  config.write_fraction=0.25;
+  config.base=0x10000000ULL;
+  config.block=64;
+  config.footprint=64ULL<<20;
+  config.stride=4096+64;
+  config.step=8;
+  config.streams=1;
+  config.skew=0.99;
+  config.hot=32ULL<<10;
+  config.hot_fraction=0.9;
+  config.phase=1000000;
+  config.sets=4;
+  snprintf(name,sizeof(name),"%s",spec);
+  field=strtok_r(name,",",&saved);
+  if(field==NULL) return 0;
+  for(int p=0;p<5;p++){
+    if(strcmp(field,patterns[p])==0) config.pattern=p;
+  }
+  if(config.pattern<0) return 0;
+  while((field=strtok_r(NULL,",",&saved))!=NULL){
+    char* value=strchr(field,'=');
+    if(value==NULL) return 0;
+    *value++='\0';
+    if(strcmp(field,"n")==0) config.accesses=parse_size(value);
+    else if(strcmp(field,"seed")==0) config.seed=strtoull(value,NULL,0);
+    else if(strcmp(field,"writes")==0) config.write_fraction=atof(value);
+    else if(strcmp(field,"base")==0) config.base=strtoull(value,NULL,16);
+    else if(strcmp(field,"block")==0) config.block=parse_size(value);
+    else if(strcmp(field,"footprint")==0) config.footprint=parse_size(value);
+    else if(strcmp(field,"stride")==0) config.stride=parse_size(value);
+    else if(strcmp(field,"step")==0) config.step=parse_size(value);
+    else if(strcmp(field,"streams")==0) config.streams=atoi(value);
+    else if(strcmp(field,"s")==0) config.skew=atof(value);
+    else if(strcmp(field,"hot")==0) config.hot=parse_size(value);
+    else if(strcmp(field,"hotfrac")==0) config.hot_fraction=atof(value);
+    else if(strcmp(field,"phase")==0) config.phase=parse_size(value);
+    else if(strcmp(field,"sets")==0) config.sets=atoi(value);
+    else return 0;
+  }
+  if(config.block==0 || config.footprint<config.block || config.streams<1 || config.sets<1 || config.phase==0
+     || config.hot<config.block || config.skew<0 || config.write_fraction<0 || config.write_fraction>1) return 0;
+  blocks=config.footprint/config.block;
+  made=0;
+  //splitmix64 of the seed, so nearby seeds give unrelated sequences, and never 0 for xorshift
+  state=config.seed+0x9E3779B97F4A7C15ULL;
+  state=(state^(state>>30))*0xBF58476D1CE4E5B9ULL;
+  state=(state^(state>>27))*0x94D049BB133111EBULL;
+  state^=state>>31;
+  if(state==0) state=1;
+  //the multiplier has to share no factor with the number of blocks so every rank gets its own block
+  spread=2654435761ULL%blocks;
+  if(spread==0) spread=1;
+  while(gcd(spread,blocks)!=1) spread++;
+  zipf_x1=zipf_integral(1.5)-1.0;
+  zipf_n=zipf_integral((double)blocks+0.5);
+  zipf_cut=2.0-zipf_inverse(zipf_integral(2.5)-zipf_h(2.0));
+  return 1;
+}
+
+
+
+uint64_t Generator::next_random(){
+  state^=state>>12;
+  state^=state<<25;
+  state^=state>>27;
+  return state*0x2545F4914F6CDD1DULL;
+}
+
+
+
+double Generator::next_uniform(){
+  return (double)(next_random()>>11)*(1.0/9007199254740992.0);
+}
+
+
+
+//the Zipf weight of rank x, and the integral of it and its inverse, written to stay accurate when s is near 1
+double Generator::zipf_h(double x){
+  return exp(-config.skew*log(x));
+}
+
+double Generator::zipf_integral(double x){
+  double log_x=log(x);
+  double t=(1.0-config.skew)*log_x;
+  double helper=fabs(t)>1e-8 ? expm1(t)/t : 1.0+t*0.5*(1.0+t*(1.0/3.0)*(1.0+0.25*t));
+  return helper*log_x;
+}
+
+double Generator::zipf_inverse(double x){
+  double t=x*(1.0-config.skew);
+  if(t<-1.0) t=-1.0;
+  double helper=fabs(t)>1e-8 ? log1p(t)/t : 1.0-t*(0.5-t*(1.0/3.0-0.25*t));
+  return exp(helper*x);
+}
+
+
+
+//rank from 1 to blocks, by rejection inversion
+uint64_t Generator::zipf_rank(){
+  for(;;){
+    double u=zipf_n+next_uniform()*(zipf_x1-zipf_n);
+    double x=zipf_inverse(u);
+    double k=floor(x+0.5);
+    if(k<1) k=1;
+    else if(k>(double)blocks) k=(double)blocks;
+    if(k-x<=zipf_cut || u>=zipf_integral(k+0.5)-zipf_h(k)) return (uint64_t)k;
+  }
+}
+
+
+
+//address of access number i
+unsigned long long Generator::address_at(uint64_t i){
+  uint64_t offset;
+  switch(config.pattern){
+  case GEN_STRIDED:
+    offset=(i*config.stride)%config.footprint;
+    break;
+  case GEN_STREAM:{
+    //the footprint is split between the streams, each one scans its part and starts over at the end
+    uint64_t part=config.footprint/config.streams;
+    uint64_t stream=i%config.streams;
+    offset=stream*part+((i/config.streams)*config.step)%part;
+    break;
+  }
+  case GEN_ZIPF:
+    offset=(((zipf_rank()-1)*spread)%blocks)*config.block;
+    break;
+  case GEN_HOTCOLD:
+    if(next_uniform()<config.hot_fraction) offset=(next_random()%(config.hot/config.block))*config.block;
+    else offset=(next_random()%blocks)*config.block;
+    break;
+  default:
+    //the working sets sit one after another, above the footprint
+    offset=((i/config.phase)%config.sets)*config.footprint+(next_random()%blocks)*config.block;
+    break;
+  }
+  return config.base+offset;
+}
+
+
+
+size_t Generator::fill(uint64_t* out, size_t max){
+  size_t count=0;
+  while(count<max && made<config.accesses){
+    unsigned long long address=address_at(made);
+    char op=next_uniform()<config.write_fraction ? 'w' : 'r';
+    out[count++]=trace_pack(address,op);
+    made++;
+  }
+  return count;
+}
@@ -0,0 +1,101 @@
+/**************************************************************************************************************
+
+Filename:     generator.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the synthetic workload generator. A generator makes up accesses
+in batches of packed records, the same way a trace is read, so it can be given anywhere the simulator takes a
+trace file and no trace has to be written to disk first. It is selected with a trace name of the form
+
+  gen:<pattern>[,<key>=<value>...]
+
+The patterns are:
+  strided   every access is stride bytes past the one before, wrapping around the footprint
+  stream    streams independent sequential scans of the footprint, interleaved, each moving step bytes
+  zipf      blocks of the footprint picked with a Zipf distribution of skew s, the hottest blocks spread over the sets
+  hotcold   hotfrac of the accesses go to a hot set of hot bytes, the rest to the whole footprint, both uniform
+  phases    uniform accesses to one of sets working sets of footprint bytes, moving to the next one every phase accesses
+
+Keys every pattern takes: n (number of accesses), seed, writes (fraction of the accesses that are writes),
+base (hex address the footprint starts at), block (bytes of a block) and footprint (bytes the accesses fall in).
+Sizes can end in K, M or G. The same name always generates the same accesses.
+
+*****************************************************************************************************************/
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//prefix of a trace name that selects a generator
+#define GEN_PREFIX "gen:"
+#define GEN_PREFIX_LEN 4
+
+//patterns a generator can make
+#define GEN_STRIDED 0
+#define GEN_STREAM 1
+#define GEN_ZIPF 2
+#define GEN_HOTCOLD 3
+#define GEN_PHASES 4
+
+//parameters of a generator, filled in from the trace name
+struct generator_config{
+  int pattern;
+  uint64_t accesses;
+  uint64_t seed;
+  double write_fraction;
+  unsigned long long base;
+  uint64_t block;
+  uint64_t footprint;
+  //strided and stream
+  uint64_t stride;
+  uint64_t step;
+  int streams;
+  //zipf
+  double skew;
+  //hotcold
+  uint64_t hot;
+  double hot_fraction;
+  //phases
+  uint64_t phase;
+  int sets;
+};
+
+
+//Class that generates the accesses of a synthetic workload
+class Generator{
+ private:
+  struct generator_config config;
+  uint64_t state;
+  uint64_t made;
+  uint64_t blocks;
+  //constants of the Zipf sampler and the odd multiplier that spreads its ranks over the footprint
+  double zipf_x1;
+  double zipf_n;
+  double zipf_cut;
+  uint64_t spread;
+  uint64_t next_random();
+  double next_uniform();
+  uint64_t zipf_rank();
+  double zipf_h(double x);
+  double zipf_integral(double x);
+  double zipf_inverse(double x);
+  unsigned long long address_at(uint64_t i);
+ public:
+  //parses a name like "zipf,n=1000000,s=0.9", without the prefix, returns 0 if it is not valid
+  int open(const char* spec);
+  //fills out with up to max records, returns how many, 0 once every access is made
+  size_t fill(uint64_t* out, size_t max);
+  const struct generator_config* get_config(){ return &config; }
+};
+
+//1 if a trace name selects a generator
+int is_generator(const char* path);
+
+#endif
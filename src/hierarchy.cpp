@@ -0,0 +1,532 @@
+/**************************************************************************************************************************
+
+Filename: hierarchy.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the hierarchy class declared in hierarchy.h.
+The L2 cache is built first, then the miss queue in front of it, then the victim cache that writes back to it,
+and then the L1 cache on top.
+The L2 cache uses the replacement policy of the L1 cache, except when LRFU is selected for the L1 cache,
+then the L2 cache uses LRU, just like the original simulator.
+Every level is built with make_cache, so its policies are fixed at compile time, or is split into shards that
+each are.
+
+****************************************************************************************************************************/
+
+#include "hierarchy.h"
+#include "trace.h"
+#include "classify.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+//fill in the configuration from the strings, in command line order
+void hierarchy_parse_config(char** params, struct hierarchy_config* config){
+  config->block_size=atoi(params[0]);
+  config->l1_size=atoi(params[1]);
+  config->l1_assoc=atoi(params[2]);
+  config->vc_size=atoi(params[3]);
+  config->l2_size=atoi(params[4]);
+  config->l2_assoc=atoi(params[5]);
+  config->replacement=replacement_of(params[6]);
+  config->address_bits=CACHE_ADDRESS_BITS;
+  config->sample_fraction=0;
+  config->shards=0;
+}
+
+
+
+//build the caches of the hierarchy
+Hierarchy::Hierarchy(const struct hierarchy_config* conf){
+  double replacement_L2;
+  int shards;
+  config=*conf;
+  //L2 uses the policy of the L1, or LRU when that is LRFU
+  replacement_L2=l2_replacement(config.replacement);
+  victim_cache=NULL;
+  second=NULL;
+  l1_shards=NULL;
+  l2_shards=NULL;
+  //a sampler looks at the counters after every access, which a sharded level only has after a whole run
+  shards=config.sample_fraction>0 ? 0 : config.shards;
+  // L2 instantiate
+  if(shardable(config.block_size,config.l2_size,config.l2_assoc,replacement_L2,shards)){
+    l2_shards=new ShardedCache(config.block_size,config.l2_size,config.l2_assoc,replacement_L2,0,NULL,2,"L2",config.address_bits,shards);
+    L2=l2_shards;
+  }
+  else L2=make_cache(config.block_size,config.l2_size,config.l2_assoc,replacement_L2,0,NULL,2,"L2",NULL,config.address_bits);
+  if(config.l2_size>0) second=L2;
+  //the levels above the L2 send it their requests through the queue
+  queue=second!=NULL ? new MissQueue(L2) : NULL;
+  pipelined=0;
+  //instantiate victim
+  victim=make_cache(config.block_size,config.vc_size,config.block_size>0 ? config.vc_size/config.block_size : 0,2,0,queue,1,"Victim",NULL,config.address_bits);
+  if(config.vc_size>0) victim_cache=victim;
+  //initiate the top level cache, the victim cache is shared by all of its sets
+  if(victim_cache==NULL && shardable(config.block_size,config.l1_size,config.l1_assoc,config.replacement,shards)){
+    l1_shards=new ShardedCache(config.block_size,config.l1_size,config.l1_assoc,config.replacement,0,queue,1,"L1",config.address_bits,shards);
+    L1=l1_shards;
+  }
+  else L1=make_cache(config.block_size,config.l1_size,config.l1_assoc,config.replacement,0,queue,1,"L1",victim_cache,config.address_bits);
+  //sample the units of sets shared by both levels, which are the sets of the level with fewer of them
+  sampler=NULL;
+  intervals=NULL;
+  memset(sample_counters,0,sizeof(sample_counters));
+  if(config.sample_fraction>0){
+    int unit_bits=(int)log2(config.l1_size/(config.block_size*config.l1_assoc));
+    if(second!=NULL){
+      int l2_bits=(int)log2(config.l2_size/(config.block_size*config.l2_assoc));
+      if(l2_bits<unit_bits) unit_bits=l2_bits;
+    }
+    sampler=new SetSampler((int)log2(config.block_size),unit_bits,config.sample_fraction);
+  }
+}
+
+
+
+Hierarchy::~Hierarchy(){
+  delete L1;
+  delete victim;
+  //stops the thread of a pipelined L2
+  if(queue!=NULL) delete queue;
+  delete L2;
+  if(sampler!=NULL) delete sampler;
+  if(intervals!=NULL) delete intervals;
+}
+
+
+
+int Hierarchy::enable_pipeline(){
+  if(queue==NULL || !queue->start()) return 0;
+  pipelined=1;
+  return 1;
+}
+
+
+
+//the L1 sends what it collected to the queue first, and the L2 gets all of it from the queue before it runs
+void Hierarchy::drain(){
+  if(l1_shards!=NULL) l1_shards->drain();
+  if(queue!=NULL) queue->drain();
+  if(l2_shards!=NULL) l2_shards->drain();
+}
+
+
+
+//pass every record of the batch in to the L1 cache, cut at the end of every interval when they are streamed
+void Hierarchy::run_batch(const uint64_t* batch, size_t count){
+  uint64_t now[INTERVAL_LEVELS][INTERVAL_METRICS];
+  if(intervals==NULL){
+    simulate_batch(batch,count);
+    return;
+  }
+  while(count>0){
+    size_t part=intervals->left()<count ? (size_t)intervals->left() : count;
+    simulate_batch(batch,part);
+    batch+=part;
+    count-=part;
+    if(intervals->advance(part)) intervals->emit(now,interval_counters(now));
+  }
+}
+
+
+
+void Hierarchy::simulate_batch(const uint64_t* batch, size_t count){
+  if(sampler!=NULL){
+    run_sampled_batch(batch,count);
+    return;
+  }
+  if(L1->classifier!=NULL){
+    run_classified_batch(batch,count);
+    return;
+  }
+  for(size_t i=0;i<count;i++) L1->cache_in(trace_address(batch[i]),trace_op(batch[i]));
+}
+
+
+
+void Hierarchy::access_batch(const uint64_t* addrs, const uint8_t* ops, size_t n){
+  uint64_t records[ACCESS_CHUNK];
+  if(sampler!=NULL || intervals!=NULL || L1->classifier!=NULL){
+    while(n>0){
+      size_t part=n<ACCESS_CHUNK ? n : ACCESS_CHUNK;
+      for(size_t i=0;i<part;i++) records[i]=trace_pack(addrs[i],(char)ops[i]);
+      run_batch(records,part);
+      addrs+=part;
+      ops+=part;
+      n-=part;
+    }
+    return;
+  }
+  //sharded levels load the sets themselves when they run
+  if(l1_shards!=NULL){
+    for(size_t i=0;i<n;i++) L1->cache_in(addrs[i],(char)ops[i]);
+    return;
+  }
+  for(size_t i=0;i<n;i++){
+    if(i+ACCESS_PREFETCH<n){
+      L1->prefetch(addrs[i+ACCESS_PREFETCH]);
+      if(second!=NULL && !pipelined && l2_shards==NULL) L2->prefetch(addrs[i+ACCESS_PREFETCH]);
+    }
+    L1->cache_in(addrs[i],(char)ops[i]);
+  }
+}
+
+
+
+void Hierarchy::warm_batch(const uint64_t* batch, size_t count){
+  for(size_t i=0;i<count;i++){
+    unsigned long long address=trace_address(batch[i]);
+    if(sampler!=NULL && sampler->slot_of(address)<0) continue;
+    L1->cache_warm(address,trace_op(batch[i]));
+  }
+}
+
+
+
+//the lower levels ran their warm-up through cache_in, so their counters are cleared with the ones of the L1
+void Hierarchy::clear_stats(){
+  drain();
+  L1->clear_stats();
+  victim->clear_stats();
+  L2->clear_stats();
+  memset(sample_counters,0,sizeof(sample_counters));
+}
+
+
+
+//start loading the shadow entries and touched bitmap words of the classifiers for a record a few records ahead,
+//which hides the host cache misses of a large level behind the simulation of the ones between
+void Hierarchy::run_classified_batch(const uint64_t* batch, size_t count){
+  MissClassifier* classifier=L1->classifier;
+  //the classifier of a pipelined L2 belongs to its thread
+  MissClassifier* lower=second!=NULL && !pipelined ? L2->classifier : NULL;
+  for(size_t i=0;i<count;i++){
+    if(i+CLASSIFY_PREFETCH<count){
+      classifier->prefetch(trace_address(batch[i+CLASSIFY_PREFETCH]));
+      if(lower!=NULL) lower->prefetch(trace_address(batch[i+CLASSIFY_PREFETCH]));
+    }
+    L1->cache_in(trace_address(batch[i]),trace_op(batch[i]));
+  }
+}
+
+
+
+//pass only the records of the sampled units in to the L1 cache, and add what each one changed to its unit
+void Hierarchy::run_sampled_batch(const uint64_t* batch, size_t count){
+  uint64_t now[SAMPLE_METRICS];
+  uint64_t deltas[SAMPLE_METRICS];
+  sampler->count(count);
+  for(size_t i=0;i<count;i++){
+    unsigned long long address=trace_address(batch[i]);
+    int slot=sampler->slot_of(address);
+    if(slot<0) continue;
+    L1->cache_in(address,trace_op(batch[i]));
+    counters(now);
+    for(int m=0;m<SAMPLE_METRICS;m++){
+      deltas[m]=now[m]-sample_counters[m];
+      sample_counters[m]=now[m];
+    }
+    sampler->add(slot,deltas);
+  }
+}
+
+
+
+//the raw counters the sampler keeps for every unit, the memory traffic is counted the same way as in calculate_stats
+void Hierarchy::counters(uint64_t* values){
+  struct cache_stats l1,l2,lowest;
+  drain();
+  L1->stats(&l1);
+  if(second!=NULL) L2->stats(&l2);
+  lowest=second!=NULL ? l2 : l1;
+  values[SAMPLE_ACCESSES]=l1.reads+l1.writes;
+  values[SAMPLE_L1_MISSES]=l1.read_misses+l1.write_misses;
+  values[SAMPLE_L2_ACCESSES]=second!=NULL ? l2.reads+l2.writes : 0;
+  values[SAMPLE_L2_MISSES]=second!=NULL ? l2.read_misses+l2.write_misses : 0;
+  values[SAMPLE_L2_WRITE_BACKS]=second!=NULL ? l2.write_backs : 0;
+  values[SAMPLE_MEM_TRAFFIC]=lowest.read_misses+lowest.write_misses+lowest.write_backs;
+}
+
+
+
+int Hierarchy::interval_counters(uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS]){
+  Cache* levels[3]={L1,victim_cache,second};
+  struct cache_stats level[3];
+  int lowest=second!=NULL ? 2 : 0;
+  int enabled=1<<INTERVAL_MEMORY;
+  drain();
+  memset(counters,0,sizeof(uint64_t)*INTERVAL_LEVELS*INTERVAL_METRICS);
+  for(int l=0;l<3;l++){
+    if(levels[l]==NULL) continue;
+    enabled|=1<<l;
+    levels[l]->stats(&level[l]);
+    counters[l][INTERVAL_READS]=level[l].reads;
+    counters[l][INTERVAL_WRITES]=level[l].writes;
+    counters[l][INTERVAL_READ_MISSES]=level[l].read_misses;
+    counters[l][INTERVAL_WRITE_MISSES]=level[l].write_misses;
+    counters[l][INTERVAL_WRITE_BACKS]=level[l].write_backs;
+    counters[l][INTERVAL_SWAPS]=level[l].swaps;
+  }
+  //the memory traffic, split the same way as in memory_traffic
+  counters[INTERVAL_MEMORY][INTERVAL_READS]=level[lowest].read_misses+level[lowest].write_misses;
+  counters[INTERVAL_MEMORY][INTERVAL_WRITES]=level[lowest].write_backs;
+  if(second==NULL && victim_cache!=NULL) counters[INTERVAL_MEMORY][INTERVAL_WRITES]+=level[1].write_backs;
+  return enabled;
+}
+
+
+
+int Hierarchy::enable_intervals(const char* path, uint64_t records){
+  uint64_t now[INTERVAL_LEVELS][INTERVAL_METRICS];
+  interval_counters(now);
+  intervals=new IntervalStream();
+  if(intervals->open(path,records,now)) return 1;
+  delete intervals;
+  intervals=NULL;
+  return 0;
+}
+
+
+
+int Hierarchy::close_intervals(){
+  uint64_t now[INTERVAL_LEVELS][INTERVAL_METRICS];
+  int closed;
+  if(intervals==NULL) return 1;
+  closed=intervals->close(now,interval_counters(now));
+  delete intervals;
+  intervals=NULL;
+  return closed;
+}
+
+
+
+void Hierarchy::calculate_stats(){
+  drain();
+  L1->calculate_stats();
+  if(victim_cache!=NULL) victim->calculate_stats();
+  if(second!=NULL) L2->calculate_stats();
+}
+
+
+
+//the memory traffic comes from the lowest enabled level
+uint64_t Hierarchy::memory_traffic(){
+  struct hierarchy_stats all;
+  stats(&all);
+  return all.memory_traffic;
+}
+
+
+
+float Hierarchy::average_access_time(){
+  struct hierarchy_stats all;
+  stats(&all);
+  return (float)all.average_access_time;
+}
+
+
+
+void Hierarchy::stats(struct hierarchy_stats* out){
+  memset(out,0,sizeof(*out));
+  drain();
+  L1->stats(&out->l1);
+  if(victim_cache!=NULL) victim->stats(&out->victim);
+  if(second!=NULL) L2->stats(&out->l2);
+  hierarchy_combine_stats(out,second!=NULL);
+}
+
+
+
+//the levels keep their times in single precision, so the access time is worked out in it too
+void hierarchy_combine_stats(struct hierarchy_stats* stats, int has_l2){
+  if(has_l2) stats->memory_traffic=stats->l2.memory_traffic;
+  else stats->memory_traffic=stats->victim.write_backs+stats->l1.memory_traffic;
+  if(!has_l2) stats->average_access_time=stats->l1.average_time;
+  else stats->average_access_time=(float)stats->l1.hit_time+(float)stats->l1.miss_rate*(float)stats->l2.average_time;
+}
+
+
+
+//report final results of L1 Cache and possibly L2 and victim
+void Hierarchy::report(ContentsDump* out){
+  drain();
+  L1->report(out);
+  if(victim_cache!=NULL) victim->report(out);
+  if(second!=NULL) L2->report(out);
+}
+
+
+
+//same formulas as calculate_stats and average_access_time
+double Hierarchy::access_time(double l1_miss_rate, double l2_miss_rate){
+  struct hierarchy_stats all;
+  stats(&all);
+  if(second==NULL) return all.l1.hit_time+l1_miss_rate*all.l1.miss_penalty;
+  return all.l1.hit_time+l1_miss_rate*(all.l2.hit_time+l2_miss_rate*all.l2.miss_penalty);
+}
+
+
+
+//extrapolate the counters of the sampled units to the whole cache
+void Hierarchy::estimate(struct sampled_stats* stats){
+  sampler->ratio(SAMPLE_L1_MISSES,SAMPLE_ACCESSES,&stats->l1_miss_rate);
+  sampler->ratio(SAMPLE_L2_MISSES,SAMPLE_L2_ACCESSES,&stats->l2_miss_rate);
+  sampler->total(SAMPLE_L1_MISSES,&stats->l1_misses);
+  sampler->total(SAMPLE_L2_MISSES,&stats->l2_misses);
+  sampler->total(SAMPLE_L2_WRITE_BACKS,&stats->l2_write_backs);
+  sampler->total(SAMPLE_MEM_TRAFFIC,&stats->memory_traffic);
+  stats->average_access_time=access_time(stats->l1_miss_rate.value,stats->l2_miss_rate.value);
+}
+
+
+
+//report the extrapolated results of a sampled hierarchy
+void Hierarchy::print_sampled_results(){
+  struct sampled_stats stats;
+  estimate(&stats);
+  printf("====== Sampled simulation results (estimated, 95%% confidence) ======\n\n");
+  printf("sampled sets:      %i of %i (%.2f%%)\n",sampler->get_sampled(),sampler->get_units(),100.0*sampler->get_sampled()/sampler->get_units());
+  printf("sampled accesses:  %llu of %llu\n\n",(unsigned long long)sampler->get_sampled_accesses(),(unsigned long long)sampler->get_total_accesses());
+  printf("L1 miss rate:          %.4f +- %.4f\n",stats.l1_miss_rate.value,stats.l1_miss_rate.error);
+  printf("L1 misses:             %.0f +- %.0f\n",stats.l1_misses.value,stats.l1_misses.error);
+  if(second!=NULL){
+    printf("L2 miss rate:          %.4f +- %.4f\n",stats.l2_miss_rate.value,stats.l2_miss_rate.error);
+    printf("L2 misses:             %.0f +- %.0f\n",stats.l2_misses.value,stats.l2_misses.error);
+    printf("L2 writeback:          %.0f +- %.0f\n",stats.l2_write_backs.value,stats.l2_write_backs.error);
+  }
+  printf("total memory traffic:  %.0f +- %.0f\n",stats.memory_traffic.value,stats.memory_traffic.error);
+  printf("average access time:   %.4f ns\n",stats.average_access_time);
+}
+
+
+
+//report final calculated results
+void Hierarchy::print_results(){
+  struct hierarchy_stats all;
+  stats(&all);
+  hierarchy_print_results(&all,second!=NULL);
+}
+
+
+
+int Hierarchy::write_stats(const char* path){
+  struct hierarchy_stats all;
+  stats(&all);
+  return hierarchy_write_stats(&all,second!=NULL,path);
+}
+
+
+
+void hierarchy_print_results(const struct hierarchy_stats* stats, int has_l2){
+  printf("\n");
+  printf("====== Simulation results (raw) ======\n\n");
+  printf("a. number of L1 reads:     %llu\n",(unsigned long long)stats->l1.reads);
+  printf("b. number of L1 read misses:    %llu\n",(unsigned long long)stats->l1.read_misses);
+  printf("c. number of L1 writes:     %llu\n",(unsigned long long)stats->l1.writes);
+  printf("d. number of L1 write misses:      %llu\n",(unsigned long long)stats->l1.write_misses);
+  printf("e. L1 miss rate:   %.4f\n",stats->l1.miss_rate);
+  printf("f. number of swaps:     %llu\n",(unsigned long long)stats->l1.swaps);
+  printf("g. number of victim cache writeback:   %llu\n",(unsigned long long)stats->victim.write_backs);
+  printf("h. number of L2 reads:     %llu\n",(unsigned long long)stats->l2.reads);
+  printf("i. number of L2 read misses:    %llu\n",(unsigned long long)stats->l2.read_misses);
+  printf("j. number of L2 writes:     %llu\n",(unsigned long long)stats->l2.writes);
+  printf("k. number of L2 write misses:      %llu\n",(unsigned long long)stats->l2.write_misses);
+  if(has_l2)printf("l. L2 miss rate:   %.4f\n",stats->l2.miss_rate);
+  else printf("l. L2 miss rate:   0\n");
+  printf("m. number of L2 writeback:  %llu\n",(unsigned long long)stats->l2.write_backs);
+  printf("n. total memory traffic:  %llu\n",(unsigned long long)stats->memory_traffic);
+  printf("\n");
+  printf("==== Simulation results (performance) ====\n");
+  printf("1. average access time:    %.4f ns",(float)stats->average_access_time);
+}
+
+
+
+//every level is written, a missing victim cache or L2 with its counters at 0. The rates are single precision in the
+//caches, 9 digits keep them exact
+int hierarchy_write_stats(const struct hierarchy_stats* stats, int has_l2, const char* path){
+  size_t length=strlen(path);
+  int json=length>=5 && strcmp(path+length-5,".json")==0;
+  const char* names[3]={"L1","Victim","L2"};
+  const char* metrics[6]={"reads","read_misses","writes","write_misses","swaps","write_backs"};
+  const struct cache_stats* levels[3]={&stats->l1,&stats->victim,&stats->l2};
+  FILE* file=fopen(path,"w");
+  if(file==NULL) return 0;
+  if(json) fprintf(file,"{\"levels\":[");
+  else fprintf(file,"level,metric,value\n");
+  for(int i=0;i<3;i++){
+    const struct cache_stats* level=levels[i];
+    uint64_t counts[6]={level->reads,level->read_misses,level->writes,level->write_misses,level->swaps,level->write_backs};
+    //a level without accesses has a miss rate of 0/0, it is written as 0
+    double miss_rate=(i==2 && !has_l2) || level->reads+level->writes==0 ? 0 : level->miss_rate;
+    if(json) fprintf(file,"%s{\"level\":\"%s\"",i>0 ? "," : "",names[i]);
+    for(int m=0;m<6;m++){
+      if(json) fprintf(file,",\"%s\":%llu",metrics[m],(unsigned long long)counts[m]);
+      else fprintf(file,"%s,%s,%llu\n",names[i],metrics[m],(unsigned long long)counts[m]);
+    }
+    //the victim cache only swaps, it has no miss rate of its own, the same as in the printed results
+    if(i!=1){
+      if(json) fprintf(file,",\"miss_rate\":%.9g",miss_rate);
+      else fprintf(file,"%s,miss_rate,%.9g\n",names[i],miss_rate);
+    }
+    if(json) fprintf(file,"}");
+  }
+  double access_time=isfinite(stats->average_access_time) ? (float)stats->average_access_time : 0;
+  if(json){
+    fprintf(file,"],\"memory_traffic\":%llu,\"average_access_time_ns\":%.9g}\n",(unsigned long long)stats->memory_traffic,
+	    access_time);
+  }
+  else{
+    fprintf(file,"Hierarchy,memory_traffic,%llu\nHierarchy,average_access_time_ns,%.9g\n",(unsigned long long)stats->memory_traffic,
+	    access_time);
+  }
+  return fclose(file)==0;
+}
+
+
+
+void Hierarchy::enable_classification(int reuse_histogram){
+  L1->enable_classifier(reuse_histogram);
+  if(second!=NULL) L2->enable_classifier(reuse_histogram);
+}
+
+
+
+void Hierarchy::print_classification(){
+  printf("\n");
+  printf("====== Miss classification ======\n\n");
+  drain();
+  if(L1->classifier!=NULL) L1->classifier->print("L1");
+  if(second!=NULL && L2->classifier!=NULL) L2->classifier->print("L2");
+}
+
+
+
+int Hierarchy::write_classification(const char* path){
+  size_t length=strlen(path);
+  int json=length>=5 && strcmp(path+length-5,".json")==0;
+  Cache* levels[2]={L1,second};
+  int written=0;
+  FILE* file=fopen(path,"w");
+  if(file==NULL) return 0;
+  drain();
+  if(json) fprintf(file,"{\"levels\":[");
+  else fprintf(file,"level,metric,bucket,value\n");
+  for(int i=0;i<2;i++){
+    if(levels[i]==NULL || levels[i]->classifier==NULL) continue;
+    if(json){
+      if(written>0) fprintf(file,",");
+      levels[i]->classifier->write_json(file,levels[i]->cache_name);
+    }
+    else levels[i]->classifier->write_csv(file,levels[i]->cache_name);
+    written++;
+  }
+  if(json) fprintf(file,"]}\n");
+  return fclose(file)==0;
+}
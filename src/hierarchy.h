@@ -0,0 +1,185 @@
+/**************************************************************************************************************
+
+Filename:     hierarchy.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the hierarchy class. A hierarchy is the L1 cache, the
+optional victim cache and the optional L2 cache wired together the same way the simulator always has.
+The configuration of a hierarchy is held in a small struct so that it can come from the command line
+or from a line of a sweep configuration file. The class also knows how to calculate and print the
+final results of a run, so every mode of the simulator reports the same numbers. A hierarchy can also simulate
+only a sample of its sets, see sample.h, and then reports estimates instead, and it can stream how its counters
+change over every interval of the trace, see interval.h. The contents of the caches are only written out when
+they are asked for, see contents.h, and the results can be written to a JSON or CSV file for scripts to read.
+
+The start of a trace can be run as a functional warm-up with warm_batch, which only changes the blocks and the
+replacement state of the caches, and clear_stats starts the statistics once the caches are warm.
+
+The L1 and victim caches do not call the L2 themselves, their fetches and write backs go to a miss queue that the
+L2 drains, see miss_queue.h. The queue is drained on the same thread unless the hierarchy is pipelined, then
+the L2 runs on a thread of its own while the L1 keeps going. The L1 and L2 can also be split by set index into
+shards that run on threads of their own, see shard.h, when nothing in them is shared by every set.
+
+The hierarchy is also the API of the simulator as a library, libcachesim.a. A program fills in a hierarchy_config,
+builds a Hierarchy from it, hands it its accesses with access_batch, and reads the results back with stats,
+without going through a trace file or the printed report.
+
+*****************************************************************************************************************/
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include "cache.h"
+#include "sample.h"
+#include "interval.h"
+#include "miss_queue.h"
+#include "shard.h"
+#include <stdint.h>
+#include <stddef.h>
+
+//number of parameters that configure a hierarchy
+#define HIERARCHY_PARAMS 7
+//how many records ahead the miss classifiers are told which block is coming
+#define CLASSIFY_PREFETCH 8
+//how many accesses ahead access_batch starts loading the sets of the L1 and L2
+#define ACCESS_PREFETCH 4
+//accesses access_batch packs into records at a time when it has to go through run_batch
+#define ACCESS_CHUNK 1024
+
+//structure that holds the configuration of a hierarchy, in the same order as the command line
+struct hierarchy_config{
+  int block_size;
+  int l1_size;
+  int l1_assoc;
+  int vc_size;
+  int l2_size;
+  int l2_assoc;
+  double replacement;
+  //width of a physical address, not part of the parameters, defaults to CACHE_ADDRESS_BITS
+  int address_bits;
+  //fraction of the sets to simulate, 0 simulates all of them without a set sampler
+  double sample_fraction;
+  //shards the L1 and L2 are each split into when they can be, 0 or 1 runs them whole, a sampled hierarchy is never split
+  int shards;
+};
+
+//results of a sampled hierarchy, extrapolated to the whole cache
+struct sampled_stats{
+  struct sample_estimate l1_miss_rate;
+  struct sample_estimate l2_miss_rate;
+  struct sample_estimate l1_misses;
+  struct sample_estimate l2_misses;
+  struct sample_estimate l2_write_backs;
+  struct sample_estimate memory_traffic;
+  //worked out from the estimated miss rates, it has no interval of its own
+  double average_access_time;
+};
+
+//statistics of every level of a hierarchy, the ones of disabled levels are 0
+struct hierarchy_stats{
+  struct cache_stats l1;
+  struct cache_stats victim;
+  struct cache_stats l2;
+  uint64_t memory_traffic;
+  double average_access_time;
+};
+
+//fills in a configuration from HIERARCHY_PARAMS strings
+void hierarchy_parse_config(char** params, struct hierarchy_config* config);
+//works out the memory traffic and average access time of a hierarchy from the statistics of its levels, and prints
+//its raw and performance results from them, has_l2 is 0 for a hierarchy without an L2
+void hierarchy_combine_stats(struct hierarchy_stats* stats, int has_l2);
+void hierarchy_print_results(const struct hierarchy_stats* stats, int has_l2);
+//writes the same results to a file, as JSON when the path ends in .json and as CSV with one level,metric,value row
+//per number otherwise, returns 0 on failure
+int hierarchy_write_stats(const struct hierarchy_stats* stats, int has_l2, const char* path);
+
+
+//Class that represents an L1 cache with an optional victim cache and L2
+class Hierarchy{
+ private:
+  //counters of the hierarchy after the last sampled access
+  uint64_t sample_counters[SAMPLE_METRICS];
+  void run_sampled_batch(const uint64_t* batch, size_t count);
+  void run_classified_batch(const uint64_t* batch, size_t count);
+  void simulate_batch(const uint64_t* batch, size_t count);
+  //streams the counters of every interval, NULL unless enable_intervals was called
+  IntervalStream* intervals;
+  //fills in the counters of every level for the interval stream and returns the levels that are enabled
+  int interval_counters(uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS]);
+ public:
+  struct hierarchy_config config;
+  //all three caches always exist, disabled ones have a size of 0
+  Cache* L1;
+  Cache* victim;
+  Cache* L2;
+  //pointers to the victim and L2 caches, NULL when they are disabled
+  Cache* victim_cache;
+  Cache* second;
+  //requests of the L1 and victim caches for the L2, NULL when the L2 is disabled
+  MissQueue* queue;
+  int pipelined;
+  //the L1 and L2 when they are split into shards, NULL when they are not. The L1 is only split without a victim cache
+  ShardedCache* l1_shards;
+  ShardedCache* l2_shards;
+  //picks the sets to simulate, NULL when every set is simulated
+  SetSampler* sampler;
+  Hierarchy(const struct hierarchy_config* conf);
+  ~Hierarchy();
+  //sends a batch of packed trace records to the L1 cache
+  void run_batch(const uint64_t* batch, size_t count);
+  //sends n accesses to the L1 cache, ops[i] is 'r' for a read of addrs[i] and 'w' for a write, the same as in a
+  //trace. A plain hierarchy loads the sets of the accesses a few ahead while it simulates, a sampled or classified
+  //one, or one streaming intervals, packs them into records for run_batch, which drops the top bit of the address
+  void access_batch(const uint64_t* addrs, const uint8_t* ops, size_t n);
+  //sends a batch of packed trace records to the L1 cache to warm it up, see cache_warm. A sampled hierarchy only
+  //warms its sampled sets. Classification and intervals are meant to be enabled once the warm-up is over
+  void warm_batch(const uint64_t* batch, size_t count);
+  //ends a warm-up, the counters of every level start again from 0
+  void clear_stats();
+  //fills in the statistics of every level so far
+  void stats(struct hierarchy_stats* out);
+  //runs the L2 on a thread of its own from now on, returns 0 when there is no L2 or the thread cannot be started
+  int enable_pipeline();
+  //brings the L2 up to date with the L1, and runs the accesses sharded levels have collected, everything in the
+  //hierarchy that looks at the caches calls it first, and so has to anything else that looks at them directly
+  void drain();
+  //calculates the final statistics of every enabled level
+  void calculate_stats();
+  //total memory traffic and average access time of the whole hierarchy
+  uint64_t memory_traffic();
+  float average_access_time();
+  //average access time for the given miss rates, with the hit times and miss penalties of the levels
+  double access_time(double l1_miss_rate, double l2_miss_rate);
+  //writes the contents of every enabled level to a dump, see contents.h
+  void report(ContentsDump* out);
+  //prints the raw and performance results, and writes them to a JSON or CSV file, which returns 0 on failure
+  void print_results();
+  int write_stats(const char* path);
+  //fills values with the SAMPLE_METRICS counters of the whole hierarchy
+  void counters(uint64_t* values);
+  //extrapolates the results of a sampled hierarchy and prints them
+  void estimate(struct sampled_stats* stats);
+  void print_sampled_results();
+  //attaches a miss classifier to the L1 and L2 caches, see classify.h, and prints or writes out what they found,
+  //a level split into shards cannot be classified and is left out,
+  //as JSON when the path ends in .json and as CSV otherwise, write_classification returns 0 on failure
+  void enable_classification(int reuse_histogram);
+  void print_classification();
+  int write_classification(const char* path);
+  //writes the counter deltas of every interval of records to a file from now on, and writes out the last one
+  //and closes the file at the end of the run, both return 0 on failure
+  int enable_intervals(const char* path, uint64_t records);
+  int close_intervals();
+  //writes the state of every cache to a checkpoint file, and restores it, see checkpoint.h, both return 0 on failure,
+  //which they always do for a hierarchy split into shards
+  int save_checkpoint(const char* path);
+  int restore_checkpoint(const char* path);
+};
+
+#endif
@@ -0,0 +1,125 @@
+/**************************************************************************************************************************
+
+Filename: interval.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the interval stream declared in interval.h.
+Rows are formatted straight into the buffer, which is written out with one fwrite when it cannot hold another
+one, so a stream of short intervals costs about as much as writing the file.
+
+****************************************************************************************************************************/
+
+#include "interval.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+//names of the levels in a CSV stream
+static const char* level_names[INTERVAL_LEVELS]={"L1","Victim","L2","Memory"};
+
+//room a CSV row needs at most, the end and six counters of up to 20 digits
+#define INTERVAL_ROW 192
+
+
+IntervalStream::IntervalStream(){
+  file=NULL;
+  binary=0;
+  failed=0;
+  interval=0;
+  position=0;
+  next_end=0;
+  buffer=NULL;
+  used=0;
+}
+
+
+
+IntervalStream::~IntervalStream(){
+  if(file!=NULL) fclose(file);
+  free(buffer);
+}
+
+
+
+int IntervalStream::open(const char* path, uint64_t records, uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS]){
+  size_t length=strlen(path);
+  if(records==0) return 0;
+  file=fopen(path,"wb");
+  if(file==NULL) return 0;
+  binary=length>=4 && strcmp(path+length-4,".bin")==0;
+  buffer=(char*)malloc(INTERVAL_BUFFER);
+  interval=records;
+  position=0;
+  next_end=records;
+  memcpy(last,counters,sizeof(last));
+  if(binary){
+    struct interval_header header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,INTERVAL_MAGIC,INTERVAL_MAGIC_LEN);
+    header.interval=interval;
+    header.metrics=INTERVAL_METRICS;
+    append(&header,sizeof(header));
+  }
+  else{
+    const char* names="end,level,reads,writes,read_misses,write_misses,write_backs,swaps\n";
+    append(names,strlen(names));
+  }
+  return 1;
+}
+
+
+
+void IntervalStream::flush(){
+  if(used>0 && fwrite(buffer,1,used,file)!=used) failed=1;
+  used=0;
+}
+
+
+
+void IntervalStream::append(const void* data, size_t length){
+  if(used+length>INTERVAL_BUFFER) flush();
+  memcpy(buffer+used,data,length);
+  used+=length;
+}
+
+
+
+void IntervalStream::emit(uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS], int enabled){
+  for(int l=0;l<INTERVAL_LEVELS;l++){
+    uint64_t deltas[INTERVAL_METRICS];
+    if(!(enabled&(1<<l))) continue;
+    for(int m=0;m<INTERVAL_METRICS;m++){
+      deltas[m]=counters[l][m]-last[l][m];
+      last[l][m]=counters[l][m];
+    }
+    if(binary){
+      struct interval_record record;
+      record.end=position;
+      record.level=l;
+      for(int m=0;m<INTERVAL_METRICS;m++) record.counts[m]=deltas[m];
+      append(&record,sizeof(record));
+    }
+    else{
+      if(used+INTERVAL_ROW>INTERVAL_BUFFER) flush();
+      used+=snprintf(buffer+used,INTERVAL_ROW,"%llu,%s,%llu,%llu,%llu,%llu,%llu,%llu\n",(unsigned long long)position,level_names[l],
+		     (unsigned long long)deltas[INTERVAL_READS],(unsigned long long)deltas[INTERVAL_WRITES],
+		     (unsigned long long)deltas[INTERVAL_READ_MISSES],(unsigned long long)deltas[INTERVAL_WRITE_MISSES],
+		     (unsigned long long)deltas[INTERVAL_WRITE_BACKS],(unsigned long long)deltas[INTERVAL_SWAPS]);
+    }
+  }
+  next_end=position+interval;
+}
+
+
+
+int IntervalStream::close(uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS], int enabled){
+  //the records since the last full interval
+  if(position+interval!=next_end) emit(counters,enabled);
+  flush();
+  if(fclose(file)!=0) failed=1;
+  file=NULL;
+  return !failed;
+}
@@ -0,0 +1,107 @@
+/**************************************************************************************************************
+
+Filename:     interval.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the interval stream. An interval stream writes out how much
+every counter of a hierarchy changed over each interval of a fixed number of trace records, so the phases of
+a long trace can be seen from one run instead of only its totals. The hierarchy cuts its batches at the
+interval boundaries, so the accesses themselves never check for one, and the rows are put together in a
+buffer owned by the simulation thread and written out when it fills, so nothing is locked.
+
+There is one row per interval for every enabled level, L1, Victim and L2, with the reads, writes, read misses,
+write misses, write backs and swaps of the level, and one row for the memory below the hierarchy, whose reads
+and writes are the memory traffic, split the same way memory_traffic counts it. A stream whose file name ends
+in .bin is binary, a header followed by fixed size records, anything else is CSV with a header line:
+
+  end,level,reads,writes,read_misses,write_misses,write_backs,swaps
+
+where end is the number of trace records simulated when the interval ended. The last interval of a run is
+written out even when it is shorter than the others.
+
+*****************************************************************************************************************/
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+//magic string at the start of every binary interval stream
+#define INTERVAL_MAGIC "CSIMIVL1"
+#define INTERVAL_MAGIC_LEN 8
+//levels a row can be for, in the order they are written
+#define INTERVAL_L1 0
+#define INTERVAL_VICTIM 1
+#define INTERVAL_L2 2
+#define INTERVAL_MEMORY 3
+#define INTERVAL_LEVELS 4
+//counters of every level
+#define INTERVAL_READS 0
+#define INTERVAL_WRITES 1
+#define INTERVAL_READ_MISSES 2
+#define INTERVAL_WRITE_MISSES 3
+#define INTERVAL_WRITE_BACKS 4
+#define INTERVAL_SWAPS 5
+#define INTERVAL_METRICS 6
+//records in an interval when none is given
+#define INTERVAL_DEFAULT 1000000
+//bytes of rows kept before they are written out
+#define INTERVAL_BUFFER (1<<16)
+
+//header at the start of every binary interval stream
+struct interval_header{
+  char magic[INTERVAL_MAGIC_LEN];
+  uint64_t interval;
+  uint64_t metrics;
+};
+
+//one row of a binary interval stream
+struct interval_record{
+  uint64_t end;
+  uint64_t level;
+  uint64_t counts[INTERVAL_METRICS];
+};
+
+
+//Class that writes the counter deltas of every interval to a file
+class IntervalStream{
+ private:
+  FILE* file;
+  int binary;
+  int failed;
+  uint64_t interval;
+  //trace records simulated so far, and where the current interval ends
+  uint64_t position;
+  uint64_t next_end;
+  //counters at the end of the last interval
+  uint64_t last[INTERVAL_LEVELS][INTERVAL_METRICS];
+  char* buffer;
+  size_t used;
+  void append(const void* data, size_t length);
+  void flush();
+ public:
+  IntervalStream();
+  ~IntervalStream();
+  //opens the file and takes the starting counters, returns 0 if the file cannot be opened
+  int open(const char* path, uint64_t records, uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS]);
+  //records left before the current interval ends
+  inline uint64_t left(){ return next_end-position; }
+  //moves the position on, returns 1 if that ended the interval
+  inline int advance(uint64_t records){
+    position+=records;
+    return position==next_end;
+  }
+  //writes the rows of the levels whose bit is set in enabled, and starts the next interval
+  void emit(uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS], int enabled);
+  //writes out the last, partial, interval and closes the file, returns 0 if anything failed to be written
+  int close(uint64_t counters[INTERVAL_LEVELS][INTERVAL_METRICS], int enabled);
+};
+
+#endif
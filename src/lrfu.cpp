@@ -0,0 +1,228 @@
+/**************************************************************************************************************************
+
+Filename: lrfu.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the functions of the cache class that make LRFU fast, declared in cache.h.
+The decayed CRF of a block at time t is 0.5^(lambda*(t-last_time_stamp))*CRF. Instead of calling pow for that on
+every access, the factors are looked up in a table built once when the cache is created. The table holds the
+exact values pow returns, so the results are the same as calling pow every time.
+
+For high associativity sets, finding the victim with a scan of every block is still O(assoc). Those sets keep
+their blocks ordered instead. The decayed CRF of a block is 2^(key-lambda*t) with key=log2(CRF)+lambda*last_time_stamp,
+so the order of the keys never changes as time goes on, and a min heap on the key gives the victim. The keys are
+measured from a shared reference time that is moved forward now and then, so they stay small and precise.
+Two cases need care to match the scan exactly. The scan picks the lowest way when decayed CRFs tie, and every
+block whose decay factor has underflowed to 0 ties at 0. Those blocks are found from the end of a per set list in
+order of last access and moved into a bitmask, where the lowest way is found with one instruction. For the rest,
+every block whose key is close enough to the smallest one that rounding could change the order is checked with
+the same math the scan uses.
+
+****************************************************************************************************************************/
+
+#include "cache.h"
+#include <stdint.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//most factors kept in the decay table
+#define LRFU_TABLE_MAX (1<<18)
+//sets with at least this many ways are kept ordered
+#define LRFU_ORDERED_WAYS 16
+//marks an empty heap position or list link
+#define LRFU_NONE 0xFFFF
+//keys within this much of the smallest one are checked exactly
+#define LRFU_TIE 1e-6
+//decayed CRFs below 2^-LRFU_SUBNORMAL are close to the denormal range and are always checked exactly
+#define LRFU_SUBNORMAL 1000.0
+//the reference time is moved forward once keys grow past this
+#define LRFU_REBASE 1048576.0
+
+
+//build the decay table, and the ordered sets if the cache needs them
+void Cache::lrfu_init(){
+  //find the first time difference whose decay factor is exactly 0
+  decay_zero=INT64_MAX;
+  if(lambda>0){
+    int64_t low=0;
+    int64_t high=(int64_t)ceil(1100.0/lambda)+1;
+    if(1100.0/lambda<4.0e18 && pow(0.5,(double)high*lambda)==0){
+      while(high-low>1){
+	int64_t middle=low+(high-low)/2;
+	if(pow(0.5,(double)middle*lambda)==0) high=middle;
+	else low=middle;
+      }
+      decay_zero=high;
+    }
+  }
+  decay_size=decay_zero<LRFU_TABLE_MAX ? decay_zero : LRFU_TABLE_MAX;
+  decay_table=(double*)malloc(decay_size*sizeof(double));
+  for(int64_t d=0;d<decay_size;d++) decay_table[d]=pow(0.5,(double)d*lambda);
+
+  //the arrays of the ordered sets are in the cache storage, only the empty positions and links need setting
+  if(lrfu_key==NULL) return;
+  size_t blocks=(size_t)num_sets*tag_stride;
+  lrfu_ref=0;
+  memset(lrfu_pos,0xFF,blocks*sizeof(uint16_t));
+  memset(lrfu_head,0xFF,num_sets*sizeof(uint16_t));
+  memset(lrfu_tail,0xFF,num_sets*sizeof(uint16_t));
+}
+
+
+
+//only high associativity sets are worth keeping ordered, and the keys only work for a decaying CRF
+int Cache::lrfu_orders_sets(){
+  return assoc>=LRFU_ORDERED_WAYS && assoc<LRFU_NONE && lambda>=0;
+}
+
+
+
+void Cache::lrfu_free(){
+  free(decay_table);
+}
+
+
+
+//move the heap entry at position up or down until the heap is in order again
+void Cache::lrfu_sift(int set, int position){
+  uint16_t* heap=&lrfu_heap[(size_t)set*assoc];
+  int size=lrfu_heap_size[set];
+  int way=heap[position];
+  double key=lrfu_key[blk(set,way)];
+  //move up while the parent is bigger, ties go to the lower way
+  while(position>0){
+    int parent=(position-1)/2;
+    int other=heap[parent];
+    double other_key=lrfu_key[blk(set,other)];
+    if(other_key<key || (other_key==key && other<way)) break;
+    heap[position]=other;
+    lrfu_pos[blk(set,other)]=position;
+    position=parent;
+  }
+  //move down while a child is smaller
+  for(;;){
+    int child=2*position+1;
+    if(child>=size) break;
+    int other=heap[child];
+    double other_key=lrfu_key[blk(set,other)];
+    if(child+1<size){
+      int right=heap[child+1];
+      double right_key=lrfu_key[blk(set,right)];
+      if(right_key<other_key || (right_key==other_key && right<other)){
+	child++;
+	other=right;
+	other_key=right_key;
+      }
+    }
+    if(key<other_key || (key==other_key && way<other)) break;
+    heap[position]=other;
+    lrfu_pos[blk(set,other)]=position;
+    position=child;
+  }
+  heap[position]=way;
+  lrfu_pos[blk(set,way)]=position;
+}
+
+
+
+void Cache::lrfu_heap_remove(int set, int way){
+  uint16_t* heap=&lrfu_heap[(size_t)set*assoc];
+  int position=lrfu_pos[blk(set,way)];
+  int last=--lrfu_heap_size[set];
+  lrfu_pos[blk(set,way)]=LRFU_NONE;
+  if(position==last) return;
+  heap[position]=heap[last];
+  lrfu_pos[blk(set,heap[position])]=position;
+  lrfu_sift(set,position);
+}
+
+
+
+//move the reference time up to now, every key drops by the same amount so the order stays the same
+void Cache::lrfu_rebase(){
+  double shift=lambda*(double)(global_counter-lrfu_ref);
+  size_t blocks=(size_t)num_sets*tag_stride;
+  for(size_t b=0;b<blocks;b++) lrfu_key[b]-=shift;
+  lrfu_ref=global_counter;
+}
+
+
+
+//the CRF and last time stamp of the block just changed, put it back in order
+void Cache::lrfu_touch(int set, int way){
+  int b=blk(set,way);
+  uint64_t bit=1ULL<<(way&63);
+  uint64_t* zero=&lrfu_zero[set*mask_words+(way>>6)];
+  if(lambda*(double)(global_counter-lrfu_ref)>LRFU_REBASE) lrfu_rebase();
+  lrfu_key[b]=log2(CRF[b])+lambda*(double)(last_time_stamp[b]-lrfu_ref);
+  *zero&=~bit;
+  if(lrfu_pos[b]==LRFU_NONE){
+    //a new block, or one whose decayed CRF had reached 0, goes into the heap
+    int position=lrfu_heap_size[set]++;
+    lrfu_heap[(size_t)set*assoc+position]=way;
+    lrfu_pos[b]=position;
+    lrfu_sift(set,position);
+  }
+  else{
+    lrfu_sift(set,lrfu_pos[b]);
+    //take the block out of the access order list
+    if(lrfu_prev[b]!=LRFU_NONE) lrfu_next[blk(set,lrfu_prev[b])]=lrfu_next[b];
+    else lrfu_head[set]=lrfu_next[b];
+    if(lrfu_next[b]!=LRFU_NONE) lrfu_prev[blk(set,lrfu_next[b])]=lrfu_prev[b];
+    else lrfu_tail[set]=lrfu_prev[b];
+  }
+  //the block was just accessed, so it goes to the front of the list
+  lrfu_prev[b]=LRFU_NONE;
+  lrfu_next[b]=lrfu_head[set];
+  if(lrfu_head[set]!=LRFU_NONE) lrfu_prev[blk(set,lrfu_head[set])]=way;
+  else lrfu_tail[set]=way;
+  lrfu_head[set]=way;
+}
+
+
+
+//find the block with the lowest decayed CRF in a full set, the lowest way wins a tie
+int Cache::lrfu_victim(int set){
+  int64_t now=global_counter;
+  uint16_t* heap=&lrfu_heap[(size_t)set*assoc];
+  int top=0;
+  int best=-1;
+  double best_CRF=0;
+  double threshold;
+  //blocks whose decay factor reached 0 are taken off the end of the access order list
+  while(lrfu_tail[set]!=LRFU_NONE && now-last_time_stamp[blk(set,lrfu_tail[set])]>=decay_zero){
+    int way=lrfu_tail[set];
+    int b=blk(set,way);
+    lrfu_tail[set]=lrfu_prev[b];
+    if(lrfu_tail[set]!=LRFU_NONE) lrfu_next[blk(set,lrfu_tail[set])]=LRFU_NONE;
+    else lrfu_head[set]=LRFU_NONE;
+    lrfu_heap_remove(set,way);
+    lrfu_zero[set*mask_words+(way>>6)]|=1ULL<<(way&63);
+  }
+  //they all have a decayed CRF of 0, which no other block can beat
+  for(int w=0;w<mask_words;w++){
+    if(lrfu_zero[set*mask_words+w]!=0) return w*64+__builtin_ctzll(lrfu_zero[set*mask_words+w]);
+  }
+  //check every block close to the top of the heap with the exact math
+  threshold=lrfu_key[blk(set,heap[0])]+LRFU_TIE;
+  if(lambda*(double)(now-lrfu_ref)-LRFU_SUBNORMAL>threshold) threshold=lambda*(double)(now-lrfu_ref)-LRFU_SUBNORMAL;
+  lrfu_stack[top++]=0;
+  while(top>0){
+    int position=lrfu_stack[--top];
+    int way=heap[position];
+    int b=blk(set,way);
+    if(lrfu_key[b]>threshold) continue;
+    double temporary_CRF=decay(now-last_time_stamp[b])*CRF[b];
+    if(best==-1 || temporary_CRF<best_CRF || (temporary_CRF==best_CRF && way<best)){
+      best=way;
+      best_CRF=temporary_CRF;
+    }
+    if(2*position+1<lrfu_heap_size[set]) lrfu_stack[top++]=2*position+1;
+    if(2*position+2<lrfu_heap_size[set]) lrfu_stack[top++]=2*position+2;
+  }
+  return best;
+}
@@ -11,36 +11,200 @@ charge of passing the command line arguments to the constructors of the instanti
 After initiating the Caches, the main file opens a specified text file that contains the trace
 that will be used for testing. Each line is read from the trace file, and from each line a hex address
 and a read/write command is extracted. These two things are then passed to the cache_in function for
-processing. 
+processing. Traces can either be in the text format or in the binary format described in trace.h,
+the format is detected when the trace is opened. In place of a trace file a synthetic workload can be
+given as gen:<pattern>[,key=value...], see generator.h, and its accesses are made up as the run goes.
+Addresses are 64 bits wide, a smaller physical address width can be given with -addr_bits after the trace file. With -sample only that fraction of the sets is
+simulated and the results are estimated, -validate also runs the full simulation to check the estimates.
+-save writes the state of the caches to a checkpoint at the end of the run, and -restore starts a run from one.
+-classify sorts the misses of the L1 and L2 into compulsory, capacity and conflict misses, see classify.h, -reuse
+adds reuse distance histograms, and -classify_out writes it all with the per set heatmaps to a CSV or JSON file.
+-interval_out streams how the counters of every level changed over each -interval records to a CSV file, or to
+a binary one when its name ends in .bin, see interval.h. -pipeline runs the L2 on a thread of its own, fed by the
+L1 and victim caches through a lock-free queue, see miss_queue.h, with the same results as a serial run.
+-hugepages off, transparent or reserved picks how large caches are put on huge pages, see arena.h. -shards splits
+the L1 and L2 by set index into that many shards, a power of 2, simulated on threads of their own, see shard.h.
+-warmup runs that many records at the start of the trace as a functional warm-up, which only fills the caches and
+counts nothing, and -warmup_marker ends the warm-up after the first access to a hex address instead, or as well,
+whichever comes first. Everything that is reported only covers the records after the warm-up, the miss
+classifiers see the warm-up but do not count it, so its blocks are not compulsory misses after it. A checkpoint
+does not hold the classifiers, so a restored run cannot be classified.
+The contents of the caches are only written out when they are asked for, -contents prints them as text and
+-contents_out writes them to a file, binary when its name ends in .bin and gzip compressed text when it ends
+in .gz, see contents.h. -stats_out writes the raw and performance results to a JSON file when its name ends in
+.json and to a CSV file otherwise, for scripts to read instead of the printed results.
 
 The newest version of the simulator supports 2 level cache hierarchy with a victim cache. More 
 raw measurements were also added to this simulation, such as the number of swaps, victim cache write backs, 
 the L2 cache miss rate, etc.
 
+The simulator can also sweep many configurations over one trace in a single run:
+  sim_cache sweep <config_file> <trace_file> [threads] [-sample FRACTION]
+it can simulate private L1 caches of several cores over a shared L2, see multicore.h:
+  sim_cache multicore <L1_BLOCKSIZE> ... <REPLACEMENT> <cores> <trace_file>... [-quantum N] [-threads N]
+it can print the LRU miss ratio curve of every associativity for one block size and set count:
+  sim_cache curve <BLOCKSIZE> <NUM_SETS> <trace_file> [max_assoc] [-verify]
+and it can run only the L1 and victim cache and write what they send to the L2 to a miss stream, and run a
+miss stream through any number of L2 caches later, see filter.h:
+  sim_cache filter <L1_BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <Victim_Cache_SIZE> <REPLACEMENT> <trace_file> <stream_file> [-addr_bits N]
+  sim_cache replay <stream_file> <L2_SIZE> <L2_ASSOC> [<L2_SIZE> <L2_ASSOC>...] [-threads N] [-contents] [-contents_out FILE] [-stats_out FILE]
+
 
 
 *****************************************************************************************************/
 #include "cache.h"
+#include "arena.h"
+#include "filter.h"
+#include "hierarchy.h"
+#include "multicore.h"
+#include "sample.h"
+#include "stack_distance.h"
+#include "sweep.h"
+#include "trace.h"
+#include "trace_stream.h"
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
 
 
 
 
 
+//records at the start of a batch that still belong to the warm-up, which ends after *left more records or after
+//the first access to the marker address. *left is 0 once the warm-up is over
+static size_t warmup_part(const uint64_t* batch, size_t count, uint64_t* left, int use_marker, unsigned long long marker){
+  size_t part=count<*left ? count : (size_t)*left;
+  if(use_marker){
+    for(size_t i=0;i<part;i++){
+      if(trace_address(batch[i])==marker){
+	*left=0;
+	return i+1;
+      }
+    }
+  }
+  *left-=part;
+  return part;
+}
+
+
 
 int main(int argc, char** argv ){
-  FILE* file;
-  unsigned long long address;
-  unsigned long long  holder;
-  char rorw;
-  char LINE_IN[1024];
-  double replacement;
-  double replacement_L2;
-  float average;
-  Cache* second=NULL;
-  Cache* victim_cache=NULL;
+  TraceStream trace;
+  const uint64_t* batch;
+  size_t count;
+  struct hierarchy_config config;
+  int validate=0;
+  const char* save_path=NULL;
+  const char* restore_path=NULL;
+  int classify=0;
+  int reuse=0;
+  const char* classify_path=NULL;
+  uint64_t interval=INTERVAL_DEFAULT;
+  const char* interval_path=NULL;
+  int pipeline=0;
+  int huge_pages=HUGE_PAGES_TRANSPARENT;
+  uint64_t warmup=0;
+  int use_marker=0;
+  unsigned long long marker=0;
+  int contents=0;
+  const char* contents_path=NULL;
+  const char* stats_path=NULL;
+  //check for the sweep mode
+  if(argc>=4 && strcmp(argv[1],"sweep")==0){
+    int threads=0;
+    double sample_fraction=0;
+    for(int i=4;i<argc;i++){
+      if(strcmp(argv[i],"-sample")==0 && i+1<argc) sample_fraction=atof(argv[++i]);
+      else threads=atoi(argv[i]);
+    }
+    return run_sweep(argv[2],argv[3],threads,sample_fraction);
+  }
+  //check for the miss ratio curve mode
+  if(argc>=5 && strcmp(argv[1],"curve")==0){
+    unsigned long long max_assoc=0;
+    int verify=0;
+    for(int i=5;i<argc;i++){
+      if(strcmp(argv[i],"-verify")==0) verify=1;
+      else max_assoc=strtoull(argv[i],NULL,10);
+    }
+    return run_curve(atoi(argv[2]),atoi(argv[3]),argv[4],max_assoc,verify);
+  }
+  //check for the filter mode, the L1 side of a configuration is followed by the trace and the stream to write
+  if(argc>=9 && strcmp(argv[1],"filter")==0){
+    char zero[]="0";
+    char* params[HIERARCHY_PARAMS]={argv[2],argv[3],argv[4],argv[5],zero,zero,argv[6]};
+    hierarchy_parse_config(params,&config);
+    for(int i=9;i<argc;i++){
+      if(strcmp(argv[i],"-addr_bits")==0 && i+1<argc) config.address_bits=atoi(argv[++i]);
+    }
+    if(config.address_bits<1 || config.address_bits>64){
+      printf("The address width must be between 1 and 64 bits\n");
+      return 1;
+    }
+    return run_filter(&config,argv[7],argv[8]);
+  }
+  //check for the replay mode, every L2 is a size and an associativity
+  if(argc>=5 && strcmp(argv[1],"replay")==0){
+    int l2_sizes[REPLAY_MAX];
+    int l2_assocs[REPLAY_MAX];
+    int num_l2=0;
+    int threads=0;
+    for(int i=3;i<argc;i++){
+      if(strcmp(argv[i],"-threads")==0 && i+1<argc) threads=atoi(argv[++i]);
+      else if(strcmp(argv[i],"-contents")==0) contents=1;
+      else if(strcmp(argv[i],"-contents_out")==0 && i+1<argc){
+	contents=1;
+	contents_path=argv[++i];
+      }
+      else if(strcmp(argv[i],"-stats_out")==0 && i+1<argc) stats_path=argv[++i];
+      else if(i+1<argc && num_l2<REPLAY_MAX){
+	l2_sizes[num_l2]=atoi(argv[i]);
+	l2_assocs[num_l2]=atoi(argv[++i]);
+	if(l2_sizes[num_l2]<=0 || l2_assocs[num_l2]<=0){
+	  printf("Every L2 needs a size and an associativity above 0\n");
+	  return 1;
+	}
+	num_l2++;
+      }
+    }
+    return run_replay(argv[2],l2_sizes,l2_assocs,num_l2,threads,contents,contents_path,stats_path);
+  }
+  //check for the multicore mode, the traces come after the number of cores and before the options
+  if(argc>=11 && strcmp(argv[1],"multicore")==0){
+    uint64_t quantum=MULTICORE_QUANTUM;
+    int threads=0;
+    int num_traces=0;
+    const char* trace_paths[MULTICORE_MAX_CORES];
+    hierarchy_parse_config(&argv[2],&config);
+    for(int i=10;i<argc;i++){
+      if(strcmp(argv[i],"-quantum")==0 && i+1<argc) quantum=strtoull(argv[++i],NULL,10);
+      else if(strcmp(argv[i],"-threads")==0 && i+1<argc) threads=atoi(argv[++i]);
+      else if(strcmp(argv[i],"-addr_bits")==0 && i+1<argc) config.address_bits=atoi(argv[++i]);
+      else if(strcmp(argv[i],"-hugepages")==0 && i+1<argc) huge_pages=huge_pages_of(argv[++i]);
+      else if(num_traces<MULTICORE_MAX_CORES) trace_paths[num_traces++]=argv[i];
+    }
+    if(config.address_bits<1 || config.address_bits>64){
+      printf("The address width must be between 1 and 64 bits\n");
+      return 1;
+    }
+    if(huge_pages<0){
+      printf("Huge pages must be off, transparent or reserved\n");
+      return 1;
+    }
+    set_huge_pages(huge_pages);
+    return run_multicore(&config,atoi(argv[9]),trace_paths,num_traces,quantum,threads);
+  }
+  if(argc<9){
+    printf("usage: %s <L1_BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <Victim_Cache_SIZE> <L2_SIZE> <L2_ASSOC> <REPLACEMENT> <trace_file> [-addr_bits N] [-restore FILE] [-save FILE] [-sample FRACTION [-validate]] [-classify] [-reuse] [-classify_out FILE] [-interval N] [-interval_out FILE] [-pipeline] [-hugepages MODE] [-shards N] [-warmup N] [-warmup_marker ADDRESS] [-contents] [-contents_out FILE] [-stats_out FILE]\n",argv[0]);
+    printf("       %s multicore <L1_BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <Victim_Cache_SIZE> <L2_SIZE> <L2_ASSOC> <REPLACEMENT> <cores> <trace_file>... [-quantum N] [-threads N] [-addr_bits N] [-hugepages MODE]\n",argv[0]);
+    printf("       %s sweep <config_file> <trace_file> [threads] [-sample FRACTION]\n",argv[0]);
+    printf("       %s curve <BLOCKSIZE> <NUM_SETS> <trace_file> [max_assoc] [-verify]\n",argv[0]);
+    printf("       %s filter <L1_BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <Victim_Cache_SIZE> <REPLACEMENT> <trace_file> <stream_file> [-addr_bits N]\n",argv[0]);
+    printf("       %s replay <stream_file> <L2_SIZE> <L2_ASSOC> [<L2_SIZE> <L2_ASSOC>...] [-threads N] [-contents] [-contents_out FILE] [-stats_out FILE]\n",argv[0]);
+    return 1;
+  }
   //print out header of report 
   printf("===== Simulator configuration =====\n");
   printf("L1_BLOCKSIZE:   %s\n",argv[1]);
@@ -50,85 +214,169 @@ int main(int argc, char** argv ){
   printf("L2_SIZE:           %s\n",argv[5]);
   printf("L2_ASSOC:          %s\n",argv[6]);
   printf("trace_file:      %s\n",argv[8]);
-  replacement=(double)atof(argv[7]);
-  if(replacement==2){
+  hierarchy_parse_config(&argv[1],&config);
+  //the physical address width and set sampling can be given after the trace file
+  for(int i=9;i<argc;i++){
+    if(strcmp(argv[i],"-addr_bits")==0 && i+1<argc) config.address_bits=atoi(argv[++i]);
+    else if(strcmp(argv[i],"-sample")==0 && i+1<argc) config.sample_fraction=atof(argv[++i]);
+    else if(strcmp(argv[i],"-validate")==0) validate=1;
+    else if(strcmp(argv[i],"-save")==0 && i+1<argc) save_path=argv[++i];
+    else if(strcmp(argv[i],"-restore")==0 && i+1<argc) restore_path=argv[++i];
+    else if(strcmp(argv[i],"-classify")==0) classify=1;
+    else if(strcmp(argv[i],"-reuse")==0) classify=reuse=1;
+    else if(strcmp(argv[i],"-classify_out")==0 && i+1<argc){
+      classify=1;
+      classify_path=argv[++i];
+    }
+    else if(strcmp(argv[i],"-interval")==0 && i+1<argc) interval=strtoull(argv[++i],NULL,10);
+    else if(strcmp(argv[i],"-interval_out")==0 && i+1<argc) interval_path=argv[++i];
+    else if(strcmp(argv[i],"-pipeline")==0) pipeline=1;
+    else if(strcmp(argv[i],"-hugepages")==0 && i+1<argc) huge_pages=huge_pages_of(argv[++i]);
+    else if(strcmp(argv[i],"-shards")==0 && i+1<argc) config.shards=atoi(argv[++i]);
+    else if(strcmp(argv[i],"-warmup")==0 && i+1<argc) warmup=strtoull(argv[++i],NULL,10);
+    else if(strcmp(argv[i],"-warmup_marker")==0 && i+1<argc){
+      use_marker=1;
+      marker=strtoull(argv[++i],NULL,16)&TRACE_ADDRESS_MASK;
+    }
+    else if(strcmp(argv[i],"-contents")==0) contents=1;
+    else if(strcmp(argv[i],"-contents_out")==0 && i+1<argc){
+      contents=1;
+      contents_path=argv[++i];
+    }
+    else if(strcmp(argv[i],"-stats_out")==0 && i+1<argc) stats_path=argv[++i];
+  }
+  if(config.address_bits<1 || config.address_bits>64){
+    printf("The address width must be between 1 and 64 bits\n");
+    return 1;
+  }
+  if(interval==0){
+    printf("The interval must be at least one record\n");
+    return 1;
+  }
+  if(huge_pages<0){
+    printf("Huge pages must be off, transparent or reserved\n");
+    return 1;
+  }
+  set_huge_pages(huge_pages);
+  if(config.sample_fraction<0 || config.sample_fraction>1){
+    printf("The sampled fraction of the sets must be between 0 and 1\n");
+    return 1;
+  }
+  if(config.replacement==2){
     printf("Replacement Policy:   LRU\n");
-    replacement_L2=2;
   }
-  else if (replacement==3){
+  else if (config.replacement==3){
     printf("Replacement Policy:    LFU\n");
-    replacement_L2=3;
+  }
+  else if(replace_policy_of(config.replacement)!=REPLACE_LRFU){
+    printf("Replacement Policy:    %s\n",replace_policy_name(replace_policy_of(config.replacement)));
   }
   else{
     printf("Replacement Policy:      LRFU\nlambda: %s\n",argv[7]);
-    replacement_L2=2;
   }
   printf("===================================\n\n");
  
   
-  // L2 instantiate 
-  Cache L2(atoi(argv[1]),atoi(argv[5]),atoi(argv[6]),replacement_L2,0,NULL,2,"L2",NULL);
-  if(atoi(argv[5])>0)second=&L2;
-  //instantiate victim
-  Cache victim(atoi(argv[1]),atoi(argv[4]),atoi(argv[4])/atoi(argv[1]),2,0,second,1,"Victim",NULL);
-  if(atoi(argv[4])>0)victim_cache=&victim;
-  //initiate the top level cache                                                                                                                                                                           
-  Cache L1(atoi(argv[1]),atoi(argv[2]),atoi(argv[3]),replacement,0,second,1,"L1",victim_cache);
+  //a sampled run prints estimates instead of the contents and raw results
+  if(config.sample_fraction>0){
+    //only some of the sets of a sampled hierarchy are warm, so it is not worth saving
+    if(save_path!=NULL) printf("A sampled run cannot save a checkpoint\n");
+    if(interval_path!=NULL) printf("A sampled run cannot stream intervals\n");
+    if(pipeline) printf("A sampled run cannot be pipelined\n");
+    if(config.shards>1) printf("A sampled run cannot be sharded\n");
+    if(warmup>0 || use_marker) printf("A sampled run cannot warm up, it can start from a checkpoint instead\n");
+    if(contents || stats_path!=NULL) printf("A sampled run cannot write out its contents or results\n");
+    return run_sample(&config,argv[8],restore_path,validate);
+  }
+  //the shards of a level each have their own blocks, so there is no one cache to classify or save
+  if(config.shards>1 && (classify || save_path!=NULL || restore_path!=NULL)){
+    printf("A classified run, or one with a checkpoint, cannot be sharded\n");
+    config.shards=0;
+  }
+  //a checkpoint does not hold the state of the classifiers, so they would start cold with the caches warm and
+  //count blocks that were touched before the checkpoint as compulsory misses
+  if(classify && restore_path!=NULL){
+    printf("A run restored from a checkpoint cannot be classified\n");
+    classify=reuse=0;
+    classify_path=NULL;
+  }
+  //instantiate the L2, victim and L1 caches
+  Hierarchy hierarchy(&config);
+  if(config.shards>1 && hierarchy.l1_shards==NULL && hierarchy.l2_shards==NULL) printf("No level of this hierarchy can be sharded\n");
+  //start from the state of an earlier run
+  if(restore_path!=NULL && !hierarchy.restore_checkpoint(restore_path)){
+    printf("Error restoring checkpoint, it has to come from the same configuration\n");
+    return 1;
+  }
+  //run the L2 next to the L1
+  if(pipeline && !hierarchy.enable_pipeline()) printf("Only a hierarchy with an L2 cache can be pipelined\n");
+  //sort the misses of every level into the three Cs, the classifiers see the warm-up too but only count after it
+  if(classify) hierarchy.enable_classification(reuse);
 
   //open the file and start passing data in to the cache
-  file=fopen(argv[8],"r");
-  if(file==NULL){
+  if(!trace.open(argv[8])){
     printf("Error opening file\n");
     return 0;
   }
-  while(fgets(LINE_IN,1024,file)!=NULL){
-    sscanf(LINE_IN,"%c %llX",&rorw,&holder);
-    address=(unsigned long long)holder;
-    L1.cache_in(address,rorw);
+  //warm the caches up on the start of the trace, the rest of the batch the warm-up ends in is run after it
+  count=0;
+  if(warmup>0 || use_marker){
+    uint64_t left=warmup>0 ? warmup : UINT64_MAX;
+    while(left>0 && (count=trace.next_batch(&batch))>0){
+      size_t part=warmup_part(batch,count,&left,use_marker,marker);
+      hierarchy.warm_batch(batch,part);
+      batch+=part;
+      count-=part;
+    }
+    if(left>0) printf("The trace ended during the warm-up\n");
+    hierarchy.clear_stats();
+  }
+  //counters are streamed from here, after a restored checkpoint or the warm-up has set them
+  if(interval_path!=NULL && !hierarchy.enable_intervals(interval_path,interval)){
+    printf("Error opening %s\n",interval_path);
+    return 1;
+  }
+  if(count>0) hierarchy.run_batch(batch,count);
+  while((count=trace.next_batch(&batch))>0){
+    hierarchy.run_batch(batch,count);
   }
   //close the file
-  fclose(file);
-  //report final results of L1 Cache and possibly L2 and victim
-  L1.report();
-  if(victim_cache!=NULL) victim.report();
-  if(second!=NULL) L2.report();
-
-
-
-  //report final calculated results                                                                                                                                                                        
-    
-  printf("\n");
-  printf("====== Simulation results (raw) ======\n\n");
-  printf("a. number of L1 reads:     %i\n",L1.num_reads);
-  printf("b. number of L1 read misses:    %i\n",L1.read_miss);
-  printf("c. number of L1 writes:     %i\n",L1.num_writes);
-  printf("d. number of L1 write misses:      %i\n",L1.write_miss);
-  printf("e. L1 miss rate:   %.4f\n",L1.miss_rate);
-  printf("f. number of swaps:     %i\n",L1.swaps);
-  printf("g. number of victim cache writeback:   %i\n",victim.write_backs);
-  printf("h. number of L2 reads:     %i\n",L2.num_reads);
-  printf("i. number of L2 read misses:    %i\n",L2.read_miss);
-  printf("j. number of L2 writes:     %i\n",L2.num_writes);
-  printf("k. number of L2 write misses:      %i\n",L2.write_miss);
-  if(second!=NULL)printf("l. L2 miss rate:   %.4f\n",L2.miss_rate);
-  else printf("l. L2 miss rate:   0\n");
-  printf("m. number of L2 writeback:  %i\n",L2.write_backs);
-  if(second!=NULL){
-    printf("n. total memory traffic:  %i\n",L2.mem_traffic);
-  }
-  else if(victim_cache!=NULL){
-    printf("n. total memory traffic:  %i\n",victim.write_backs+L1.mem_traffic);
+  trace.close();
+  if(!hierarchy.close_intervals()){
+    printf("Error writing %s\n",interval_path);
+    return 1;
   }
-  else{
-    printf("n. total memory traffic:  %i\n",L1.mem_traffic);
+  //keep the state for a later run
+  if(save_path!=NULL && !hierarchy.save_checkpoint(save_path)){
+    printf("Error saving checkpoint\n");
+    return 1;
   }
-  printf("\n");
-  printf("==== Simulation results (performance) ====\n");
-  if(second==NULL){
-    printf("1. average access time:    %.4f ns",L1.average_time);
+  //write out the contents of the L1 Cache and possibly L2 and victim, only when they are asked for
+  if(contents){
+    ContentsDump dump;
+    if(!dump.open(contents_path)){
+      printf("Error opening %s\n",contents_path);
+      return 1;
+    }
+    hierarchy.report(&dump);
+    if(!dump.close()){
+      printf("Error writing %s\n",contents_path!=NULL ? contents_path : "the contents");
+      return 1;
+    }
   }
-  else{
-    printf("1. average access time:    %.4f ns",L1.hit_time+(L1.miss_rate)*L2.average_time);
+  //report final calculated results
+  hierarchy.print_results();
+  if(stats_path!=NULL && !hierarchy.write_stats(stats_path)){
+    printf("Error writing %s\n",stats_path);
+    return 1;
+  }
+  if(classify){
+    printf("\n");
+    hierarchy.print_classification();
+    if(classify_path!=NULL && !hierarchy.write_classification(classify_path)){
+      printf("Error writing %s\n",classify_path);
+      return 1;
+    }
   }
   return 0;
 }
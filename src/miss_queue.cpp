@@ -0,0 +1,149 @@
+/**************************************************************************************************************************
+
+Filename: miss_queue.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the miss queue declared in miss_queue.h.
+Both sides batch what they tell the other one, the writer publishes its position every MISS_QUEUE_PUBLISH
+requests and the reader its own after every run of up to MISS_QUEUE_BATCH requests, so the two threads do not bounce
+the host cache line of a position back and forth on every request. A side that has to wait spins for a while
+and then yields, so the pipelined mode still makes progress on a machine with one CPU.
+
+****************************************************************************************************************************/
+
+#include "miss_queue.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+//position of a request in the ring
+#define MISS_QUEUE_MASK (MISS_QUEUE_SIZE-1)
+
+
+//spin, and yield once the other thread has taken too long
+static void wait_for_other(int* spins){
+  if(++*spins<MISS_QUEUE_SPINS){
+#if defined(__SSE2__)
+    _mm_pause();
+#endif
+    return;
+  }
+  *spins=0;
+  sched_yield();
+}
+
+
+
+//a disabled cache, so it is never looked at, only its cache_in is called
+MissQueue::MissQueue(Cache* next) : Cache(0,0,0,2,0,NULL,2,"Queue",NULL){
+  addresses=(unsigned long long*)malloc(MISS_QUEUE_SIZE*sizeof(unsigned long long));
+  ops=(char*)malloc(MISS_QUEUE_SIZE);
+  target=next;
+  head=0;
+  seen_tail=0;
+  published=0;
+  tail=0;
+  seen_head=0;
+  stopping=0;
+  threaded=0;
+}
+
+
+
+MissQueue::~MissQueue(){
+  stop();
+  free(addresses);
+  free(ops);
+}
+
+
+
+void MissQueue::publish(){
+  __atomic_store_n(&published,head,__ATOMIC_RELEASE);
+}
+
+
+
+void MissQueue::cache_in(unsigned long long address, char r_or_w){
+  //the ring is full, so the requests in it have to be run first
+  if(head-seen_tail==MISS_QUEUE_SIZE){
+    int spins=0;
+    publish();
+    if(!threaded) run_published();
+    while(head-(seen_tail=__atomic_load_n(&tail,__ATOMIC_ACQUIRE))==MISS_QUEUE_SIZE) wait_for_other(&spins);
+  }
+  addresses[head&MISS_QUEUE_MASK]=address;
+  ops[head&MISS_QUEUE_MASK]=r_or_w;
+  head++;
+  if((head&(MISS_QUEUE_PUBLISH-1))==0) publish();
+}
+
+
+
+void MissQueue::run_published(){
+  uint64_t position=tail;
+  seen_head=__atomic_load_n(&published,__ATOMIC_ACQUIRE);
+  while(position!=seen_head){
+    //a run stops at the end of the ring
+    size_t start=position&MISS_QUEUE_MASK;
+    size_t count=seen_head-position;
+    if(count>MISS_QUEUE_SIZE-start) count=MISS_QUEUE_SIZE-start;
+    if(count>MISS_QUEUE_BATCH) count=MISS_QUEUE_BATCH;
+    target->cache_in_batch(&addresses[start],&ops[start],count);
+    position+=count;
+    __atomic_store_n(&tail,position,__ATOMIC_RELEASE);
+  }
+}
+
+
+
+void* MissQueue::reader_main(void* arg){
+  MissQueue* queue=(MissQueue*)arg;
+  int spins=0;
+  for(;;){
+    if(__atomic_load_n(&queue->published,__ATOMIC_ACQUIRE)!=queue->tail){
+      queue->run_published();
+      spins=0;
+    }
+    //stop only sets stopping once the ring is empty
+    else if(__atomic_load_n(&queue->stopping,__ATOMIC_ACQUIRE)) break;
+    else wait_for_other(&spins);
+  }
+  return NULL;
+}
+
+
+
+int MissQueue::start(){
+  if(threaded) return 1;
+  drain();
+  stopping=0;
+  if(pthread_create(&thread,NULL,reader_main,this)!=0) return 0;
+  threaded=1;
+  return 1;
+}
+
+
+
+void MissQueue::drain(){
+  int spins=0;
+  publish();
+  if(!threaded) run_published();
+  while((seen_tail=__atomic_load_n(&tail,__ATOMIC_ACQUIRE))!=head) wait_for_other(&spins);
+}
+
+
+
+void MissQueue::stop(){
+  if(!threaded) return;
+  drain();
+  __atomic_store_n(&stopping,1,__ATOMIC_RELEASE);
+  pthread_join(thread,NULL);
+  threaded=0;
+}
@@ -0,0 +1,84 @@
+/**************************************************************************************************************
+
+Filename:     miss_queue.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the miss queue. A miss queue sits between a level of a
+hierarchy and the level below it. The levels above write their fetches and write backs to it instead of calling
+cache_in of the level below, and the level below drains it in the order they were written, so every level runs
+its own loop over its own accesses instead of all of them sharing one deep call stack. Nothing a level below
+does changes the levels above, so the level below sees exactly the accesses it would have seen from the calls.
+
+The queue is a ring of MISS_QUEUE_SIZE requests with one writer and one reader. Run serially, the thread that
+writes it also drains it, but only when the ring is full or when drain is called, so the L2 runs in bursts of up
+to a full ring behind the L1. Pipelined, the level below
+runs on a thread of its own that drains the ring while the levels above fill it. The two only share the write
+and read positions, which are published with release stores and read with acquire loads, so there are no locks,
+and the results are the same as the serial ones. Anything that looks at the level below has to call drain first,
+which waits until the thread has caught up.
+
+The reader hands the requests to the level below in runs with cache_in_batch, so that level loads the sets of
+the next few requests while it runs the current one.
+
+Like the request queue of the multicore mode, a miss queue is a disabled Cache whose cache_in only records the
+request, so the levels above it run exactly the code they run without one.
+
+*****************************************************************************************************************/
+#ifndef MISS_QUEUE_H
+#define MISS_QUEUE_H
+
+#include "cache.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+//requests the ring holds, a power of two
+#define MISS_QUEUE_SIZE 1024
+//requests the writer puts in the ring before it tells the reader about them
+#define MISS_QUEUE_PUBLISH 64
+//most requests the reader hands the level below in one cache_in_batch before it tells the writer about them
+#define MISS_QUEUE_BATCH 256
+//times a thread that waits on the other one spins before it gives up the CPU
+#define MISS_QUEUE_SPINS 256
+
+//Class that queues the requests a level sends to the level below it
+class MissQueue : public Cache{
+ private:
+  //address and op, 'r' or 'w' as in cache_in, of every fetch and write back in the ring
+  unsigned long long* addresses;
+  char* ops;
+  //level the requests are for
+  Cache* target;
+  //requests written and requests run on the target, each on its own host cache line. The writer owns head and
+  //publishes it in published, the reader owns tail, and each side keeps the last value it saw of the other
+  alignas(64) uint64_t head;
+  uint64_t seen_tail;
+  alignas(64) uint64_t published;
+  alignas(64) uint64_t tail;
+  uint64_t seen_head;
+  alignas(64) int stopping;
+  int threaded;
+  pthread_t thread;
+  void publish();
+  //runs every request the reader has been told about on the target
+  void run_published();
+  static void* reader_main(void* queue);
+ public:
+  MissQueue(Cache* target);
+  ~MissQueue();
+  void cache_in(unsigned long long address, char r_or_w);
+  //starts the thread that drains the ring, returns 0 if it cannot be started
+  int start();
+  //runs every queued request on the target, or waits until the thread has
+  void drain();
+  //drains the ring and stops the thread
+  void stop();
+};
+
+#endif
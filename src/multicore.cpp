@@ -0,0 +1,509 @@
+/**************************************************************************************************************************
+
+Filename: multicore.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the multicore mode declared in multicore.h.
+The main thread reads the accesses of the next quantum while the worker threads run the bound phase of the
+current one, and then weaves it on its own. Each worker owns a fixed group of cores, the same way the workers
+of a sweep own a fixed group of hierarchies, and two barriers separate the quanta.
+
+The private caches of a core write to a request queue instead of the L2, which is a Cache whose cache_in only
+records the request, so the L1 and victim caches run exactly the code they run in a normal hierarchy.
+
+****************************************************************************************************************************/
+
+#include "multicore.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+//bytes of one line of a shared trace
+#define MULTICORE_LINE 1024
+
+
+//a disabled cache, so it is never looked at, only its cache_in is called
+RequestQueue::RequestQueue() : Cache(0,0,0,2,0,NULL,2,"Queue",NULL){
+  capacity=1024;
+  count=0;
+  now=0;
+  requests=(struct core_request*)malloc(capacity*sizeof(struct core_request));
+}
+
+
+
+RequestQueue::~RequestQueue(){
+  free(requests);
+}
+
+
+
+void RequestQueue::push(unsigned long long address, char op){
+  if(count==capacity){
+    capacity*=2;
+    requests=(struct core_request*)realloc(requests,capacity*sizeof(struct core_request));
+  }
+  requests[count].time=now;
+  requests[count].address=address;
+  requests[count].op=op;
+  count++;
+}
+
+
+
+//build the shared L2 and the private caches of every core, the same way a hierarchy builds them
+Multicore::Multicore(const struct hierarchy_config* conf, int n, uint64_t q){
+  double replacement_L2;
+  config=*conf;
+  num_cores=n;
+  quantum=q;
+  transfers=0;
+  skipped=0;
+  shared=NULL;
+  shared_time=0;
+  shared_done=0;
+  block_bits=(int)log2(config.block_size);
+  address_mask=config.address_bits>=64 ? ~0ULL : (1ULL<<config.address_bits)-1;
+  //L2 uses the policy of the L1, or LRU when that is LRFU
+  replacement_L2=l2_replacement(config.replacement);
+  second=NULL;
+  L2=make_cache(config.block_size,config.l2_size,config.l2_assoc,replacement_L2,0,NULL,2,"L2",NULL,config.address_bits);
+  if(config.l2_size>0) second=L2;
+  directory=new BlockMap(1024);
+  positions=(size_t*)malloc(num_cores*sizeof(size_t));
+  cores=(struct core_state*)calloc(num_cores,sizeof(struct core_state));
+  for(int c=0;c<num_cores;c++){
+    struct core_state* core=&cores[c];
+    core->queue=new RequestQueue();
+    core->victim=make_cache(config.block_size,config.vc_size,config.block_size>0 ? config.vc_size/config.block_size : 0,2,0,core->queue,1,"Victim",NULL,config.address_bits);
+    core->L1=make_cache(config.block_size,config.l1_size,config.l1_assoc,config.replacement,0,core->queue,1,"L1",config.vc_size>0 ? core->victim : NULL,config.address_bits);
+    for(int b=0;b<2;b++){
+      core->records[b]=(uint64_t*)malloc(quantum*sizeof(uint64_t));
+      core->times[b]=(uint64_t*)malloc(quantum*sizeof(uint64_t));
+    }
+  }
+}
+
+
+
+Multicore::~Multicore(){
+  for(int c=0;c<num_cores;c++){
+    struct core_state* core=&cores[c];
+    delete core->L1;
+    delete core->victim;
+    delete core->queue;
+    if(core->trace!=NULL) delete core->trace;
+    for(int b=0;b<2;b++){
+      free(core->records[b]);
+      free(core->times[b]);
+    }
+  }
+  if(shared!=NULL) gzclose(shared);
+  delete L2;
+  delete directory;
+  free(positions);
+  free(cores);
+}
+
+
+
+int Multicore::open(const char** paths, int num_paths){
+  if(num_paths==num_cores){
+    for(int c=0;c<num_cores;c++){
+      cores[c].trace=new TraceStream();
+      if(!cores[c].trace->open(paths[c])) return 0;
+    }
+    return 1;
+  }
+  if(num_paths!=1) return 0;
+  shared=gzopen(paths[0],"rb");
+  if(shared==NULL) return 0;
+  gzbuffer(shared,TRACE_TEXT_CHUNK);
+  return 1;
+}
+
+
+
+//parses a line of a shared trace, an access followed by the core that made it, a line without a core belongs to core 0
+static int parse_core_line(const char* line, uint64_t* record, int* core){
+  const char* c=line+1;
+  char* end;
+  if(!trace_parse_line(line,record)) return 0;
+  //skip the op and the address, trace_parse_line already checked them
+  while(*c==' ' || *c=='\t') c++;
+  if(c[0]=='0' && (c[1]=='x' || c[1]=='X')) c+=2;
+  while((*c>='0' && *c<='9') || (*c>='a' && *c<='f') || (*c>='A' && *c<='F')) c++;
+  long id=strtol(c,&end,10);
+  *core=end==c ? 0 : (int)id;
+  return 1;
+}
+
+
+
+//every line of the shared trace up to time end goes to the core it names
+int Multicore::fill_shared(int buffer, uint64_t start, uint64_t end){
+  char LINE_IN[MULTICORE_LINE];
+  uint64_t record;
+  int core;
+  for(int c=0;c<num_cores;c++) cores[c].counts[buffer]=0;
+  while(shared_time<end && !shared_done){
+    if(gzgets(shared,LINE_IN,MULTICORE_LINE)==NULL){
+      shared_done=1;
+      break;
+    }
+    if(!parse_core_line(LINE_IN,&record,&core)) continue;
+    if(core<0 || core>=num_cores) skipped++;
+    else{
+      struct core_state* owner=&cores[core];
+      owner->records[buffer][owner->counts[buffer]]=record;
+      owner->times[buffer][owner->counts[buffer]]=shared_time;
+      owner->counts[buffer]++;
+    }
+    shared_time++;
+  }
+  return shared_time>start;
+}
+
+
+
+int Multicore::fill(int buffer, uint64_t start){
+  int any=0;
+  if(shared!=NULL) return fill_shared(buffer,start,start+quantum);
+  //every core takes the next quantum accesses of its own trace
+  for(int c=0;c<num_cores;c++){
+    struct core_state* core=&cores[c];
+    size_t n=0;
+    while(n<quantum){
+      if(core->batch_left==0){
+	core->batch_left=core->trace->next_batch(&core->batch);
+	if(core->batch_left==0) break;
+      }
+      size_t take=core->batch_left<quantum-n ? core->batch_left : quantum-n;
+      memcpy(&core->records[buffer][n],core->batch,take*sizeof(uint64_t));
+      for(size_t i=0;i<take;i++) core->times[buffer][n+i]=start+n+i;
+      core->batch+=take;
+      core->batch_left-=take;
+      n+=take;
+    }
+    core->counts[buffer]=n;
+    if(n>0) any=1;
+  }
+  return any;
+}
+
+
+
+void Multicore::bound(int c, int buffer){
+  struct core_state* core=&cores[c];
+  RequestQueue* queue=core->queue;
+  const uint64_t* records=core->records[buffer];
+  const uint64_t* times=core->times[buffer];
+  size_t count=core->counts[buffer];
+  queue->count=0;
+  for(size_t i=0;i<count;i++){
+    unsigned long long address=trace_address(records[i]);
+    char op=trace_op(records[i]);
+    queue->now=times[i];
+    //a write to a block that is not Modified here has to take it away from the other cores first
+    if(op=='w' && num_cores>1){
+      int state=core->L1->state_of(address);
+      if(state!=2) queue->push(address,state==1 ? 'u' : 'o');
+    }
+    core->L1->cache_in(address,op);
+  }
+}
+
+
+
+void Multicore::weave(){
+  for(int c=0;c<num_cores;c++) positions[c]=0;
+  for(;;){
+    //the earliest time any queue still has a request for
+    uint64_t time=~0ULL;
+    for(int c=0;c<num_cores;c++){
+      RequestQueue* queue=cores[c].queue;
+      if(positions[c]<queue->count && queue->requests[positions[c]].time<time) time=queue->requests[positions[c]].time;
+    }
+    if(time==~0ULL) break;
+    for(int c=0;c<num_cores;c++){
+      RequestQueue* queue=cores[c].queue;
+      while(positions[c]<queue->count && queue->requests[positions[c]].time==time){
+	struct core_request* request=&queue->requests[positions[c]++];
+	if(request->op=='u' || request->op=='o') upgrade(c,request->address,request->op=='u');
+	else if(request->op=='r') fetch(c,request->address);
+	else write_back(c,request->address);
+      }
+    }
+  }
+}
+
+
+
+//the writer becomes the only sharer, every other copy is invalidated, a dirty one is handed over to the writer.
+//Only a block the writer held Shared is an upgrade, a clean block nobody else shares is Exclusive and turns
+//Modified silently
+void Multicore::upgrade(int c, unsigned long long address, int held){
+  uint64_t block=(address&address_mask)>>block_bits;
+  uint64_t* entry=directory->find(block);
+  uint64_t others=entry!=NULL ? *entry&~DIRECTORY_MODIFIED&~(1ULL<<c) : 0;
+  if(held && others!=0) cores[c].upgrades++;
+  while(others!=0){
+    int sharer=__builtin_ctzll(others);
+    others&=others-1;
+    int state=cores[sharer].L1->invalidate(address);
+    if(state!=0) cores[sharer].invalidations++;
+    if(state==2) transfers++;
+  }
+  directory->insert(block,(1ULL<<c)|DIRECTORY_MODIFIED);
+}
+
+
+
+//a core that has the block Modified writes it back and keeps it Shared, then the block is read from the L2
+void Multicore::fetch(int c, unsigned long long address){
+  uint64_t block=(address&address_mask)>>block_bits;
+  uint64_t* entry=directory->find(block);
+  if(entry==NULL){
+    directory->insert(block,1ULL<<c);
+  }
+  else{
+    if((*entry&DIRECTORY_MODIFIED) && !(*entry&(1ULL<<c))){
+      int owner=__builtin_ctzll(*entry&~DIRECTORY_MODIFIED);
+      if(cores[owner].L1->downgrade(address)){
+	cores[owner].downgrades++;
+	if(second!=NULL) L2->cache_in(address,'w');
+      }
+      *entry&=~DIRECTORY_MODIFIED;
+    }
+    *entry|=1ULL<<c;
+  }
+  if(second!=NULL) L2->cache_in(address,'r');
+}
+
+
+
+//a write back is always an eviction, so the core no longer holds the block
+void Multicore::write_back(int c, unsigned long long address){
+  uint64_t block=(address&address_mask)>>block_bits;
+  uint64_t* entry=directory->find(block);
+  if(entry!=NULL){
+    *entry&=~(1ULL<<c);
+    if((*entry&~DIRECTORY_MODIFIED)==0) directory->erase(block);
+  }
+  if(second!=NULL) L2->cache_in(address,'w');
+}
+
+
+
+void Multicore::calculate_stats(){
+  for(int c=0;c<num_cores;c++){
+    cores[c].L1->calculate_stats();
+    if(config.vc_size>0) cores[c].victim->calculate_stats();
+  }
+  if(second!=NULL) L2->calculate_stats();
+}
+
+
+
+uint64_t Multicore::memory_traffic(){
+  uint64_t traffic=0;
+  struct cache_stats stats;
+  if(second!=NULL){
+    L2->stats(&stats);
+    return stats.memory_traffic;
+  }
+  for(int c=0;c<num_cores;c++){
+    cores[c].L1->stats(&stats);
+    traffic+=stats.memory_traffic+cores[c].downgrades;
+    if(config.vc_size>0){
+      cores[c].victim->stats(&stats);
+      traffic+=stats.write_backs;
+    }
+  }
+  return traffic;
+}
+
+
+
+//report final results of every core, the shared L2 and the coherence traffic
+void Multicore::print_results(){
+  uint64_t upgrades=0,invalidations=0,downgrades=0;
+  struct cache_stats l2;
+  memset(&l2,0,sizeof(l2));
+  if(second!=NULL) L2->stats(&l2);
+  printf("\n");
+  printf("====== Multicore simulation results (raw) ======\n\n");
+  printf("%4s %10s %10s %10s %10s %8s %8s %8s %9s %9s %9s %10s\n",
+	 "CORE","READS","READ_MISS","WRITES","WRITE_MISS","MISS_RT","SWAPS","WB","UPGRADES","INVALID","DOWNGRADE","AAT_NS");
+  for(int c=0;c<num_cores;c++){
+    struct core_state* core=&cores[c];
+    struct cache_stats l1,victim;
+    core->L1->stats(&l1);
+    //write backs that leave the core come from the victim cache when there is one
+    if(config.vc_size>0) core->victim->stats(&victim);
+    uint64_t write_backs=config.vc_size>0 ? victim.write_backs : l1.write_backs;
+    float access_time=second!=NULL ? (float)l1.hit_time+(float)l1.miss_rate*(float)l2.average_time : (float)l1.average_time;
+    printf("%4i %10llu %10llu %10llu %10llu %8.4f %8llu %8llu %9llu %9llu %9llu %10.4f\n",
+	   c,(unsigned long long)l1.reads,(unsigned long long)l1.read_misses,(unsigned long long)l1.writes,
+	   (unsigned long long)l1.write_misses,l1.miss_rate,(unsigned long long)l1.swaps,(unsigned long long)write_backs,
+	   (unsigned long long)core->upgrades,(unsigned long long)core->invalidations,(unsigned long long)core->downgrades,access_time);
+    upgrades+=core->upgrades;
+    invalidations+=core->invalidations;
+    downgrades+=core->downgrades;
+  }
+  printf("\n");
+  printf("a. number of L2 reads:     %llu\n",(unsigned long long)l2.reads);
+  printf("b. number of L2 read misses:    %llu\n",(unsigned long long)l2.read_misses);
+  printf("c. number of L2 writes:     %llu\n",(unsigned long long)l2.writes);
+  printf("d. number of L2 write misses:      %llu\n",(unsigned long long)l2.write_misses);
+  if(second!=NULL)printf("e. L2 miss rate:   %.4f\n",l2.miss_rate);
+  else printf("e. L2 miss rate:   0\n");
+  printf("f. number of L2 writeback:  %llu\n",(unsigned long long)l2.write_backs);
+  printf("g. total memory traffic:  %llu\n",(unsigned long long)memory_traffic());
+  printf("h. number of upgrades:     %llu\n",(unsigned long long)upgrades);
+  printf("i. number of invalidations:     %llu\n",(unsigned long long)invalidations);
+  printf("j. number of dirty transfers:     %llu\n",(unsigned long long)transfers);
+  printf("k. number of downgrades:     %llu\n",(unsigned long long)downgrades);
+}
+
+
+
+//state shared between the main thread and the workers
+struct multicore_state{
+  Multicore* multicore;
+  int num_threads;
+  //set of accesses the workers are running, and 0 once every quantum is done
+  int buffer;
+  int running;
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+};
+
+//what each worker is handed when it is created
+struct multicore_worker{
+  struct multicore_state* state;
+  int id;
+};
+
+
+
+//worker thread, runs the bound phase of every num_threads-th core starting at its id
+static void* multicore_worker_main(void* arg){
+  struct multicore_worker* worker=(struct multicore_worker*)arg;
+  struct multicore_state* state=worker->state;
+  Multicore* multicore=state->multicore;
+  for(;;){
+    pthread_barrier_wait(&state->start);
+    if(!state->running) break;
+    for(int c=worker->id;c<multicore->num_cores;c+=state->num_threads) multicore->bound(c,state->buffer);
+    pthread_barrier_wait(&state->done);
+  }
+  return NULL;
+}
+
+
+
+int run_multicore(const struct hierarchy_config* config, int num_cores, const char** trace_paths, int num_traces, uint64_t quantum, int threads){
+  struct multicore_state state;
+  struct multicore_worker* workers=NULL;
+  pthread_t* handles=NULL;
+  struct timeval begin,end;
+  double seconds;
+  unsigned long long total=0;
+  uint64_t start=0;
+  int buffer=0;
+  int more;
+
+  if(num_cores<1 || num_cores>MULTICORE_MAX_CORES){
+    printf("The number of cores must be between 1 and %i\n",MULTICORE_MAX_CORES);
+    return 1;
+  }
+  if(num_traces!=num_cores && num_traces!=1){
+    printf("Give one trace per core, or one trace that names the core of every access\n");
+    return 1;
+  }
+  if(config->l1_size<=0 || quantum==0){
+    printf("The multicore mode needs an L1 cache and a quantum of at least one access\n");
+    return 1;
+  }
+  Multicore multicore(config,num_cores,quantum);
+  if(!multicore.open(trace_paths,num_traces)){
+    printf("Error opening file\n");
+    return 1;
+  }
+  if(threads<=0) threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads<1) threads=1;
+  if(threads>num_cores) threads=num_cores;
+
+  printf("===== Multicore configuration =====\n");
+  printf("L1_BLOCKSIZE:   %i\n",config->block_size);
+  printf("L1_SIZE:        %i\n",config->l1_size);
+  printf("L1_ASSOC:       %i\n",config->l1_assoc);
+  printf("Victim_Cache_SIZE:    %i \n",config->vc_size);
+  printf("L2_SIZE:           %i\n",config->l2_size);
+  printf("L2_ASSOC:          %i\n",config->l2_assoc);
+  printf("cores:          %i\n",num_cores);
+  printf("quantum:        %llu\n",(unsigned long long)quantum);
+  printf("threads:        %i\n",threads);
+  for(int i=0;i<num_traces;i++) printf("trace_file:      %s\n",trace_paths[i]);
+  printf("===================================\n");
+
+  gettimeofday(&begin,NULL);
+  state.multicore=&multicore;
+  state.num_threads=threads;
+  state.running=1;
+  if(threads>1){
+    pthread_barrier_init(&state.start,NULL,threads+1);
+    pthread_barrier_init(&state.done,NULL,threads+1);
+    workers=(struct multicore_worker*)malloc(threads*sizeof(struct multicore_worker));
+    handles=(pthread_t*)malloc(threads*sizeof(pthread_t));
+    for(int i=0;i<threads;i++){
+      workers[i].state=&state;
+      workers[i].id=i;
+      pthread_create(&handles[i],NULL,multicore_worker_main,&workers[i]);
+    }
+  }
+  more=multicore.fill(buffer,start);
+  while(more){
+    for(int c=0;c<num_cores;c++) total+=multicore.cores[c].counts[buffer];
+    if(threads>1){
+      //run the bound phase on the workers and read the next quantum meanwhile
+      state.buffer=buffer;
+      pthread_barrier_wait(&state.start);
+      more=multicore.fill(buffer^1,start+quantum);
+      pthread_barrier_wait(&state.done);
+    }
+    else{
+      for(int c=0;c<num_cores;c++) multicore.bound(c,buffer);
+      more=multicore.fill(buffer^1,start+quantum);
+    }
+    multicore.weave();
+    buffer^=1;
+    start+=quantum;
+  }
+  if(threads>1){
+    state.running=0;
+    pthread_barrier_wait(&state.start);
+    for(int i=0;i<threads;i++) pthread_join(handles[i],NULL);
+    pthread_barrier_destroy(&state.start);
+    pthread_barrier_destroy(&state.done);
+    free(workers);
+    free(handles);
+  }
+  gettimeofday(&end,NULL);
+  seconds=(double)(end.tv_sec-begin.tv_sec)+(double)(end.tv_usec-begin.tv_usec)/1000000.0;
+
+  multicore.calculate_stats();
+  multicore.print_results();
+  if(multicore.get_skipped()>0) printf("\nskipped %llu accesses of cores that do not exist\n",(unsigned long long)multicore.get_skipped());
+  printf("\nsimulated %llu accesses on %i cores with %i threads in %.3f s\n",total,num_cores,threads,seconds);
+  return 0;
+}
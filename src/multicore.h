@@ -0,0 +1,154 @@
+/**************************************************************************************************************
+
+Filename:     multicore.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the multicore mode of the simulator. Every core has a private L1
+cache, with an optional victim cache, and all of them share one L2 cache. The accesses of the cores come either
+from one trace per core, or from one text trace whose lines name the core after the address, "r 1f3c0 2".
+
+The private caches are kept coherent with MESI. The state of a block is not stored, it follows from the caches
+and a directory: a block in a private cache is Modified when it is dirty, Exclusive when it is clean and no
+other core shares it, Shared otherwise, and Invalid when the core does not hold it. The directory maps every
+block to the mask of the cores that may hold it and a bit that is set while one of them has written it. A write
+to a block that is not already Modified invalidates every other copy, and a fetch of a block that another core
+has Modified makes that core write it back to the L2 and keep it Shared. Clean blocks are evicted silently, like
+in most real directories, so the directory can list a core that no longer holds the block, and the invalidation
+sent to it finds nothing.
+
+Cores are simulated in bounded time quanta. In the first, bound, phase of a quantum every core runs its next
+accesses on its private caches, on its own thread, and whatever leaves them, fetches, write backs and writes that
+need other copies invalidated, is queued with the time of the access that caused it. In the second, weave,
+phase the queues of all cores are merged in time order, ties going to the lower core, and applied to the
+directory and the L2 on one thread. So a core only sees the invalidations of the other cores at the end of a
+quantum, and can hit on a stale copy until then, which bounds the error by the length of the quantum. The
+results only depend on the quantum, never on the number of threads, and a single core gives exactly the same
+results as the normal mode.
+
+Time is the index of an access in its own trace when every core has a trace, so the cores take turns one
+access at a time, and the line number when all cores share a trace.
+
+*****************************************************************************************************************/
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include "cache.h"
+#include "hierarchy.h"
+#include "block_map.h"
+#include "trace_stream.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <zlib.h>
+
+//most cores a run can have, one bit of a directory entry each
+#define MULTICORE_MAX_CORES 63
+//bit of a directory entry that is set while the block is Modified in the core that shares it
+#define DIRECTORY_MODIFIED 0x8000000000000000ULL
+//accesses per core in a quantum when none is given
+#define MULTICORE_QUANTUM 10000
+
+//what a core sends out of its private caches, op is 'r' for a fetch, 'w' for a write back, and 'u' for a write
+//to a block the core holds clean or 'o' for a write miss, which both have to invalidate the other copies
+//of the block
+struct core_request{
+  uint64_t time;
+  unsigned long long address;
+  char op;
+};
+
+
+//Cache that stands in for the L2 below the private caches of a core and queues what they send to it
+class RequestQueue : public Cache{
+ public:
+  struct core_request* requests;
+  size_t count;
+  size_t capacity;
+  //time of the access the core is simulating
+  uint64_t now;
+  RequestQueue();
+  ~RequestQueue();
+  void push(unsigned long long address, char op);
+  void cache_in(unsigned long long address, char r_or_w){ push(address,r_or_w); }
+};
+
+
+//the private caches of one core and the accesses it runs in the current quantum
+struct core_state{
+  Cache* L1;
+  Cache* victim;
+  RequestQueue* queue;
+  //accesses of the quantum and their times, filled by the main thread, two sets so the next quantum can be read
+  //while this one runs
+  uint64_t* records[2];
+  uint64_t* times[2];
+  size_t counts[2];
+  //trace of this core when every core has its own, and the part of its last batch not run yet
+  TraceStream* trace;
+  const uint64_t* batch;
+  size_t batch_left;
+  //coherence counters, writes to blocks it held Shared, which MESI upgrades to Modified, and blocks it lost to
+  //other cores
+  uint64_t upgrades;
+  uint64_t invalidations;
+  uint64_t downgrades;
+};
+
+
+//Class that represents the private caches of every core over a shared L2
+class Multicore{
+ private:
+  BlockMap* directory;
+  int block_bits;
+  unsigned long long address_mask;
+  //shared trace when the cores do not have one each, and the time of its next line
+  gzFile shared;
+  uint64_t shared_time;
+  int shared_done;
+  //accesses of the shared trace that named a core that does not exist
+  uint64_t skipped;
+  //next request of every queue to weave
+  size_t* positions;
+  //coherence actions of the weave phase
+  //held is 1 when the core has the block clean, so the write is an upgrade if any other core shares it, and 0
+  //for a write miss, a read for ownership
+  void upgrade(int core, unsigned long long address, int held);
+  void fetch(int core, unsigned long long address);
+  void write_back(int core, unsigned long long address);
+  int fill_shared(int buffer, uint64_t start, uint64_t end);
+ public:
+  struct hierarchy_config config;
+  int num_cores;
+  struct core_state* cores;
+  Cache* L2;
+  //the L2 cache, NULL when it is disabled
+  Cache* second;
+  uint64_t quantum;
+  //dirty blocks handed from one core to another by an invalidation
+  uint64_t transfers;
+  Multicore(const struct hierarchy_config* conf, int num_cores, uint64_t quantum);
+  ~Multicore();
+  //opens one trace per core, or one shared trace when only one path is given, returns 0 on failure
+  int open(const char** paths, int num_paths);
+  //reads the accesses of the quantum that starts at start in to one of the two sets, returns 0 when every trace is done
+  int fill(int buffer, uint64_t start);
+  //bound phase of one core, runs its accesses on its private caches
+  void bound(int core, int buffer);
+  //weave phase, applies the queued requests of every core in time order
+  void weave();
+  void calculate_stats();
+  //total memory traffic, counted the same way as in a hierarchy, plus the write backs of downgrades without an L2
+  uint64_t memory_traffic();
+  void print_results();
+  uint64_t get_skipped(){ return skipped; }
+};
+
+//runs the multicore mode, threads of 0 uses one thread per host core up to the number of simulated cores
+int run_multicore(const struct hierarchy_config* config, int num_cores, const char** trace_paths, int num_traces, uint64_t quantum, int threads);
+
+#endif
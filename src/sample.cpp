@@ -0,0 +1,198 @@
+/**************************************************************************************************************************
+
+Filename: sample.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the set sampler declared in sample.h, and the sample mode
+of the simulator. The sample mode runs one hierarchy on a sample of its sets and prints the estimated results.
+The hierarchy can start from a checkpoint, then only what happens after it is estimated.
+With validation it runs the full hierarchy on the same trace afterwards and prints both results side by side,
+with the error of every estimate, whether the full result is inside its confidence interval, and the speedup.
+
+****************************************************************************************************************************/
+
+#include "sample.h"
+#include "hierarchy.h"
+#include "trace.h"
+#include "trace_stream.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <sys/time.h>
+
+//seed of the random numbers that pick the sampled units, fixed so runs can be repeated
+#define SAMPLE_SEED 0x9E3779B97F4A7C15ULL
+
+
+SetSampler::SetSampler(int block_bits, int unit_bits, double fraction){
+  int32_t* order;
+  uint64_t state=SAMPLE_SEED;
+  this->block_bits=block_bits;
+  num_units=1<<unit_bits;
+  unit_mask=(uint64_t)num_units-1;
+  num_sampled=(int)(fraction*num_units+0.5);
+  //at least two units are needed to see how much they differ
+  if(num_sampled<2) num_sampled=2;
+  if(num_sampled>num_units) num_sampled=num_units;
+  slots=(int32_t*)malloc(num_units*sizeof(int32_t));
+  sums=(uint64_t*)calloc((size_t)num_sampled*SAMPLE_METRICS,sizeof(uint64_t));
+  total_accesses=0;
+  //shuffle the first num_sampled units into place, the rest are left out
+  order=(int32_t*)malloc(num_units*sizeof(int32_t));
+  for(int u=0;u<num_units;u++){
+    order[u]=u;
+    slots[u]=-1;
+  }
+  for(int i=0;i<num_sampled;i++){
+    //xorshift random numbers
+    state^=state<<13;
+    state^=state>>7;
+    state^=state<<17;
+    int pick=i+(int)(state%(uint64_t)(num_units-i));
+    int32_t hold=order[i];
+    order[i]=order[pick];
+    order[pick]=hold;
+    slots[order[i]]=i;
+  }
+  free(order);
+}
+
+
+
+SetSampler::~SetSampler(){
+  free(slots);
+  free(sums);
+}
+
+
+
+uint64_t SetSampler::get_sampled_accesses(){
+  uint64_t accesses=0;
+  for(int i=0;i<num_sampled;i++) accesses+=sums[(size_t)i*SAMPLE_METRICS+SAMPLE_ACCESSES];
+  return accesses;
+}
+
+
+
+//ratio estimate of metric over base, the variance comes from how far each unit is from the ratio
+void SetSampler::ratio(int metric, int base, struct sample_estimate* estimate){
+  double sum_metric=0,sum_base=0,spread=0,mean_base;
+  double n=(double)num_sampled;
+  for(int i=0;i<num_sampled;i++){
+    sum_metric+=(double)sums[(size_t)i*SAMPLE_METRICS+metric];
+    sum_base+=(double)sums[(size_t)i*SAMPLE_METRICS+base];
+  }
+  estimate->value=0;
+  estimate->error=0;
+  if(sum_base==0) return;
+  estimate->value=sum_metric/sum_base;
+  for(int i=0;i<num_sampled;i++){
+    double d=(double)sums[(size_t)i*SAMPLE_METRICS+metric]-estimate->value*(double)sums[(size_t)i*SAMPLE_METRICS+base];
+    spread+=d*d;
+  }
+  //every unit was simulated, so there is nothing to estimate
+  if(num_sampled==num_units) return;
+  mean_base=sum_base/n;
+  //variance of the ratio with the finite population correction
+  estimate->error=SAMPLE_Z*sqrt((1.0-n/(double)num_units)*spread/(n-1.0)/(n*mean_base*mean_base));
+}
+
+
+
+//the total number of accesses is known, so a total is the accesses times its ratio to them
+void SetSampler::total(int metric, struct sample_estimate* estimate){
+  ratio(metric,SAMPLE_ACCESSES,estimate);
+  estimate->value*=(double)total_accesses;
+  estimate->error*=(double)total_accesses;
+}
+
+
+
+//run a hierarchy over the whole trace and return the seconds it took, or -1 if the trace could not be opened
+static double run_trace(Hierarchy* hierarchy, const char* trace_path){
+  TraceStream trace;
+  const uint64_t* batch;
+  size_t count;
+  struct timeval begin,end;
+  if(!trace.open(trace_path)) return -1;
+  gettimeofday(&begin,NULL);
+  while((count=trace.next_batch(&batch))>0) hierarchy->run_batch(batch,count);
+  gettimeofday(&end,NULL);
+  trace.close();
+  return (double)(end.tv_sec-begin.tv_sec)+(double)(end.tv_usec-begin.tv_usec)/1000000.0;
+}
+
+
+
+//print one row of the validation table, rates are printed with digits decimals and counts with none
+static void print_check(const char* name, int digits, const struct sample_estimate* estimate, double full, int* misses){
+  double error=full!=0 ? 100.0*(estimate->value-full)/full : 0.0;
+  int inside=fabs(estimate->value-full)<=estimate->error+1e-9*fabs(full);
+  if(!inside) (*misses)++;
+  printf("%-22s %14.*f %12.*f %14.*f %9.2f%% %6s\n",name,digits,estimate->value,digits,estimate->error,digits,full,error,inside ? "yes" : "NO");
+}
+
+
+
+//ratio of two counter changes, 0 if the base did not change
+static double rate(const uint64_t* before, const uint64_t* after, int metric, int base){
+  uint64_t count=after[base]-before[base];
+  return count>0 ? (double)(after[metric]-before[metric])/(double)count : 0.0;
+}
+
+
+
+int run_sample(const struct hierarchy_config* config, const char* trace_path, const char* restore_path, int validate){
+  struct hierarchy_config full_config=*config;
+  struct sampled_stats stats;
+  uint64_t before[SAMPLE_METRICS];
+  uint64_t after[SAMPLE_METRICS];
+  double sampled_seconds,full_seconds;
+  double l1_miss_rate,l2_miss_rate;
+  int misses=0;
+  if(config->vc_size>0){
+    printf("Set sampling does not support a victim cache, it is shared by every set\n");
+    return 1;
+  }
+  Hierarchy sampled(config);
+  if(restore_path!=NULL && !sampled.restore_checkpoint(restore_path)){
+    printf("Error restoring checkpoint, it has to come from the same configuration\n");
+    return 1;
+  }
+  sampled_seconds=run_trace(&sampled,trace_path);
+  if(sampled_seconds<0){
+    printf("Error opening file\n");
+    return 1;
+  }
+  sampled.print_sampled_results();
+  if(!validate) return 0;
+
+  //simulate every set of the same hierarchy, from the same checkpoint, and compare what changed during the trace
+  full_config.sample_fraction=0;
+  Hierarchy full(&full_config);
+  if(restore_path!=NULL) full.restore_checkpoint(restore_path);
+  full.counters(before);
+  full_seconds=run_trace(&full,trace_path);
+  full.counters(after);
+  sampled.estimate(&stats);
+  l1_miss_rate=rate(before,after,SAMPLE_L1_MISSES,SAMPLE_ACCESSES);
+  l2_miss_rate=rate(before,after,SAMPLE_L2_MISSES,SAMPLE_L2_ACCESSES);
+  printf("\n===== Validation against full simulation =====\n");
+  printf("%-22s %14s %12s %14s %10s %6s\n","METRIC","SAMPLED","+-95%","FULL","ERROR","IN_CI");
+  print_check("L1 miss rate",4,&stats.l1_miss_rate,l1_miss_rate,&misses);
+  print_check("L1 misses",0,&stats.l1_misses,(double)(after[SAMPLE_L1_MISSES]-before[SAMPLE_L1_MISSES]),&misses);
+  if(full.second!=NULL){
+    print_check("L2 miss rate",4,&stats.l2_miss_rate,l2_miss_rate,&misses);
+    print_check("L2 misses",0,&stats.l2_misses,(double)(after[SAMPLE_L2_MISSES]-before[SAMPLE_L2_MISSES]),&misses);
+    print_check("L2 writeback",0,&stats.l2_write_backs,(double)(after[SAMPLE_L2_WRITE_BACKS]-before[SAMPLE_L2_WRITE_BACKS]),&misses);
+  }
+  print_check("total memory traffic",0,&stats.memory_traffic,(double)(after[SAMPLE_MEM_TRAFFIC]-before[SAMPLE_MEM_TRAFFIC]),&misses);
+  printf("%-22s %14.4f %12s %14.4f\n","average access time",stats.average_access_time,"",full.access_time(l1_miss_rate,l2_miss_rate));
+  printf("\nsampled run: %.3f s, full run: %.3f s, speedup: %.1fx\n",sampled_seconds,full_seconds,
+	 sampled_seconds>0 ? full_seconds/sampled_seconds : 0.0);
+  printf("%i of the full results are outside their confidence interval\n",misses);
+  return 0;
+}
@@ -0,0 +1,92 @@
+/**************************************************************************************************************
+
+Filename:     sample.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the set sampler. Large caches take most of the time of a
+simulation, but their sets are mostly independent of each other, so simulating a random subset of the sets
+and scaling the results up gives a good estimate of the whole cache in a fraction of the time.
+
+The sampled unit is a group of sets that only ever exchange blocks with each other. The L1 set of an access is
+the low bits of its block address, and so is its L2 set, so the sets picked by the smaller of the two set
+counts give every level a consistent subset of the trace. Accesses outside the sampled units are dropped before
+they reach the L1 cache. A victim cache is shared by every set, so it cannot be sampled this way.
+
+The counters that every access changes are added up per sampled unit. Totals are estimated with a ratio
+estimator, the total number of accesses in the trace is known exactly, and each metric is scaled by its
+ratio to the accesses of the sampled units. The spread of that ratio across the units gives a 95% confidence
+interval, with the finite population correction so that sampling every set has no error at all.
+
+*****************************************************************************************************************/
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//counters kept for every sampled unit
+#define SAMPLE_ACCESSES 0
+#define SAMPLE_L1_MISSES 1
+#define SAMPLE_L2_ACCESSES 2
+#define SAMPLE_L2_MISSES 3
+#define SAMPLE_L2_WRITE_BACKS 4
+#define SAMPLE_MEM_TRAFFIC 5
+#define SAMPLE_METRICS 6
+//z value of a two sided 95% confidence interval
+#define SAMPLE_Z 1.96
+
+struct hierarchy_config;
+
+//an estimate and the half width of its 95% confidence interval
+struct sample_estimate{
+  double value;
+  double error;
+};
+
+
+//Class that picks the sampled units and extrapolates their counters to the whole cache
+class SetSampler{
+ private:
+  int block_bits;
+  uint64_t unit_mask;
+  int num_units;
+  int num_sampled;
+  //slot of every unit in sums, -1 if the unit is not sampled
+  int32_t* slots;
+  //SAMPLE_METRICS counters for every sampled unit
+  uint64_t* sums;
+  //every access in the trace, sampled or not
+  uint64_t total_accesses;
+ public:
+  //samples about fraction of the 2^unit_bits units, at least two of them, picked at random with a fixed seed
+  SetSampler(int block_bits, int unit_bits, double fraction);
+  ~SetSampler();
+  //slot of the unit an address belongs to, or -1 if it is not sampled
+  inline int slot_of(unsigned long long address){ return slots[(address>>block_bits)&unit_mask]; }
+  //adds the counter changes of one access to its unit
+  inline void add(int slot, const uint64_t* deltas){
+    uint64_t* sum=&sums[(size_t)slot*SAMPLE_METRICS];
+    for(int m=0;m<SAMPLE_METRICS;m++) sum[m]+=deltas[m];
+  }
+  void count(size_t accesses){ total_accesses+=accesses; }
+  //ratio of two metrics over the whole cache, like a miss rate
+  void ratio(int metric, int base, struct sample_estimate* estimate);
+  //total of a metric over the whole cache
+  void total(int metric, struct sample_estimate* estimate);
+  int get_units(){ return num_units; }
+  int get_sampled(){ return num_sampled; }
+  uint64_t get_total_accesses(){ return total_accesses; }
+  uint64_t get_sampled_accesses();
+};
+
+//runs one sampled hierarchy on a trace and prints the extrapolated results, restore_path is a checkpoint to
+//start from or NULL, with validate the full hierarchy is also run and compared against them
+int run_sample(const struct hierarchy_config* config, const char* trace_path, const char* restore_path, int validate);
+
+#endif
@@ -0,0 +1,282 @@
+/**************************************************************************************************************************
+
+Filename: shard.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the sharded cache declared in shard.h.
+The calling thread splits every run between the shards, runs the first shard itself while the threads run the
+others, and then merges the logs. Every access of a run is numbered, and the log of every shard is in the order of those
+numbers, so the merge only walks the run once, taking the requests of each access from the log of its shard. The threads sleep on a condition variable between runs, a run is long enough that waking them up costs
+little next to it.
+
+****************************************************************************************************************************/
+
+#include "shard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+//A disabled cache that logs the requests a shard sends to the next level, the way the miss queue queues them
+class ShardLog : public Cache{
+ public:
+  unsigned long long* addresses;
+  char* ops;
+  uint32_t* numbers;
+  size_t count;
+  size_t capacity;
+  //number of the access the shard is running
+  uint32_t number;
+  //puts the shard bits back in to the addresses the shard sends
+  int shard;
+  int block_bits;
+  int shard_bits;
+  ShardLog(int shard_index, int block, int bits) : Cache(0,0,0,2,0,NULL,2,"Log",NULL){
+    //an access sends at most a write back and a fetch, so this is only outgrown when most accesses miss
+    capacity=SHARD_BATCH;
+    addresses=(unsigned long long*)malloc(capacity*sizeof(unsigned long long));
+    ops=(char*)malloc(capacity);
+    numbers=(uint32_t*)malloc(capacity*sizeof(uint32_t));
+    count=0;
+    number=0;
+    shard=shard_index;
+    block_bits=block;
+    shard_bits=bits;
+  }
+  ~ShardLog(){
+    free(addresses);
+    free(ops);
+    free(numbers);
+  }
+  void cache_in(unsigned long long address, char r_or_w){
+    if(count==capacity){
+      capacity*=2;
+      addresses=(unsigned long long*)realloc(addresses,capacity*sizeof(unsigned long long));
+      ops=(char*)realloc(ops,capacity);
+      numbers=(uint32_t*)realloc(numbers,capacity*sizeof(uint32_t));
+    }
+    unsigned long long offset=address&((1ULL<<block_bits)-1);
+    addresses[count]=((address>>block_bits)<<(block_bits+shard_bits))|((unsigned long long)shard<<block_bits)|offset;
+    ops[count]=r_or_w;
+    numbers[count]=number;
+    count++;
+  }
+};
+
+
+
+int shardable(int blocksize, int size, int ass, double rep_policy, int shards){
+  int policy=replace_policy_of(rep_policy);
+  if(shards<2 || shards>SHARD_MAX || (shards&(shards-1))!=0) return 0;
+  if(blocksize<=0 || size<=0 || ass<=0 || size/(blocksize*ass)<shards) return 0;
+  //the RRIP policies that count over every set
+  return policy!=REPLACE_BRRIP && policy!=REPLACE_DRRIP;
+}
+
+
+
+//the cache itself is disabled, its shards hold the blocks
+ShardedCache::ShardedCache(int blocksize, int size, int ass, double rep_policy, int wr_policy, Cache* next_cache, int level, const char* name, int addr_bits, int shards_wanted)
+  : Cache(0,0,0,2,0,NULL,level,name,NULL){
+  num_shards=shards_wanted;
+  shard_bits=(int)log2(num_shards);
+  block_bits=(int)log2(blocksize);
+  total_sets=size/(blocksize*ass);
+  ways=ass;
+  shard_mask=(unsigned long long)(num_shards-1)<<block_bits;
+  address_mask=addr_bits>=64 ? ~0ULL : (1ULL<<addr_bits)-1;
+  target=next_cache;
+  shards=new Cache*[num_shards];
+  logs=target!=NULL ? new ShardLog*[num_shards] : NULL;
+  for(int k=0;k<num_shards;k++){
+    if(logs!=NULL) logs[k]=new ShardLog(k,block_bits,shard_bits);
+    shards[k]=make_cache(blocksize,size,ass,rep_policy,wr_policy,logs!=NULL ? logs[k] : NULL,level,name,NULL,addr_bits,num_shards);
+  }
+  addresses=(unsigned long long*)malloc(SHARD_BATCH*sizeof(unsigned long long));
+  ops=(char*)malloc(SHARD_BATCH);
+  shard_of=(uint8_t*)malloc(SHARD_BATCH);
+  count=0;
+  clock=0;
+  //any shard can get the whole run
+  for(int k=0;k<num_shards;k++){
+    runs[k].addresses=(unsigned long long*)malloc(SHARD_BATCH*sizeof(unsigned long long));
+    runs[k].ops=(char*)malloc(SHARD_BATCH);
+    runs[k].numbers=(uint32_t*)malloc(SHARD_BATCH*sizeof(uint32_t));
+    runs[k].owner=this;
+    runs[k].shard=k;
+  }
+  pthread_mutex_init(&lock,NULL);
+  pthread_cond_init(&started,NULL);
+  pthread_cond_init(&done,NULL);
+  generation=0;
+  finished=0;
+  stopping=0;
+  //shard 0 runs on the calling thread, and so do the shards of any threads that could not be started
+  workers=0;
+  for(int k=1;k<num_shards;k++){
+    if(pthread_create(&runs[k].thread,NULL,worker_main,&runs[k])!=0) break;
+    workers++;
+  }
+}
+
+
+
+ShardedCache::~ShardedCache(){
+  pthread_mutex_lock(&lock);
+  stopping=1;
+  pthread_cond_broadcast(&started);
+  pthread_mutex_unlock(&lock);
+  for(int k=1;k<=workers;k++) pthread_join(runs[k].thread,NULL);
+  pthread_mutex_destroy(&lock);
+  pthread_cond_destroy(&started);
+  pthread_cond_destroy(&done);
+  for(int k=0;k<num_shards;k++){
+    delete shards[k];
+    if(logs!=NULL) delete logs[k];
+    free(runs[k].addresses);
+    free(runs[k].ops);
+    free(runs[k].numbers);
+  }
+  delete[] shards;
+  delete[] logs;
+  free(addresses);
+  free(ops);
+  free(shard_of);
+}
+
+
+
+void ShardedCache::cache_in(unsigned long long address, char r_or_w){
+  addresses[count]=address;
+  ops[count]=r_or_w;
+  if(++count==SHARD_BATCH) run();
+}
+
+
+
+void ShardedCache::cache_in_batch(const unsigned long long* batch_addresses, const char* batch_ops, size_t batch_count){
+  for(size_t i=0;i<batch_count;i++) ShardedCache::cache_in(batch_addresses[i],batch_ops[i]);
+}
+
+
+
+void ShardedCache::cache_warm(unsigned long long address, char r_or_w){
+  ShardedCache::cache_in(address,r_or_w);
+}
+
+
+
+void ShardedCache::run_shard(int shard){
+  struct shard_run* r=&runs[shard];
+  Cache* cache=shards[shard];
+  ShardLog* log=logs!=NULL ? logs[shard] : NULL;
+  if(log!=NULL) log->count=0;
+  for(size_t j=0;j<r->count;j++){
+    if(j+CACHE_PREFETCH<r->count) cache->prefetch(r->addresses[j+CACHE_PREFETCH]);
+    if(log!=NULL) log->number=r->numbers[j];
+    cache->set_clock(clock+r->numbers[j]);
+    cache->cache_in(r->addresses[j],r->ops[j]);
+  }
+}
+
+
+
+void* ShardedCache::worker_main(void* arg){
+  struct shard_run* r=(struct shard_run*)arg;
+  ShardedCache* owner=r->owner;
+  uint64_t seen=0;
+  for(;;){
+    pthread_mutex_lock(&owner->lock);
+    while(owner->generation==seen && !owner->stopping) pthread_cond_wait(&owner->started,&owner->lock);
+    if(owner->stopping){
+      pthread_mutex_unlock(&owner->lock);
+      break;
+    }
+    seen=owner->generation;
+    pthread_mutex_unlock(&owner->lock);
+    owner->run_shard(r->shard);
+    pthread_mutex_lock(&owner->lock);
+    if(++owner->finished==owner->workers) pthread_cond_signal(&owner->done);
+    pthread_mutex_unlock(&owner->lock);
+  }
+  return NULL;
+}
+
+
+
+void ShardedCache::run(){
+  unsigned long long offset_mask=(1ULL<<block_bits)-1;
+  size_t next[SHARD_MAX];
+  if(count==0) return;
+  //split the run by the shard bits of the set index, and take them out of the addresses
+  for(int k=0;k<num_shards;k++) runs[k].count=0;
+  for(size_t i=0;i<count;i++){
+    unsigned long long address=addresses[i]&address_mask;
+    int k=(int)((address&shard_mask)>>block_bits);
+    struct shard_run* r=&runs[k];
+    shard_of[i]=(uint8_t)k;
+    r->addresses[r->count]=((address>>(block_bits+shard_bits))<<block_bits)|(address&offset_mask);
+    r->ops[r->count]=ops[i];
+    r->numbers[r->count]=(uint32_t)i;
+    r->count++;
+  }
+  pthread_mutex_lock(&lock);
+  finished=0;
+  generation++;
+  pthread_cond_broadcast(&started);
+  pthread_mutex_unlock(&lock);
+  run_shard(0);
+  for(int k=workers+1;k<num_shards;k++) run_shard(k);
+  pthread_mutex_lock(&lock);
+  while(finished<workers) pthread_cond_wait(&done,&lock);
+  pthread_mutex_unlock(&lock);
+  //send the requests of every access on in the order of the accesses
+  if(logs!=NULL){
+    memset(next,0,sizeof(next));
+    for(size_t i=0;i<count;i++){
+      int k=shard_of[i];
+      ShardLog* log=logs[k];
+      while(next[k]<log->count && log->numbers[next[k]]==(uint32_t)i){
+	target->cache_in(log->addresses[next[k]],log->ops[next[k]]);
+	next[k]++;
+      }
+    }
+  }
+  clock+=(int64_t)count;
+  count=0;
+}
+
+
+
+void ShardedCache::drain(){
+  run();
+}
+
+
+
+void ShardedCache::calculate_stats(){
+  run();
+  sum_counters(shards,num_shards);
+  Cache::calculate_stats();
+}
+
+
+
+void ShardedCache::clear_stats(){
+  run();
+  for(int k=0;k<num_shards;k++) shards[k]->clear_stats();
+  Cache::clear_stats();
+}
+
+
+
+//the sets in the order of the whole cache, set s is set s>>shard_bits of shard s&(num_shards-1)
+void ShardedCache::report(ContentsDump* out){
+  calculate_stats();
+  out->begin_level(cache_name,total_sets,ways);
+  for(int s=0;s<total_sets;s++) shards[s&(num_shards-1)]->dump_set(out,s>>shard_bits,s);
+}
@@ -0,0 +1,120 @@
+/**************************************************************************************************************
+
+Filename:     shard.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the sharded cache. Accesses to different sets of a cache never
+change each other, so a cache can be split by set index into shards that are simulated on threads of their own.
+Shard k of a cache with 2^b shards holds the sets whose low b bits are k. It is a Cache of its own with the sets
+numbered without those bits, and it is handed addresses with those b bits taken out, so its tags are the tags of
+the whole cache. Each shard keeps its own arrays, so no two threads ever write to the same set.
+
+A sharded cache collects the accesses it is given into runs of SHARD_BATCH. It hands every shard its own part of
+a run, runs the shards on their threads, and waits for all of them. A shard does not call the next level itself,
+it logs its fetches and write backs with the number of the access that caused them, with the shard bits put back
+in to their addresses, and once every shard is done the logs are sent to the next level in the order of those
+numbers. That is the order the whole cache would have sent them in, so the next level sees exactly the same
+requests as without shards. LRFU time stamps count every access of the cache, so each shard is told the number
+of an access before it runs it.
+
+A shard only sees its own sets, so state that is shared by every set cannot be kept. BRRIP and DRRIP count
+insertions and misses over the whole cache, a victim cache is shared by every set of its L1, and a miss
+classifier keeps one fully associative shadow for the whole cache, so none of those can be sharded.
+
+The counters and contents of a sharded cache are the ones of its shards put together, after any collected
+accesses have been run.
+
+*****************************************************************************************************************/
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "cache.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+//most shards a cache can be split into
+#define SHARD_MAX 64
+//accesses collected before the shards run them
+#define SHARD_BATCH 65536
+
+class ShardLog;
+class ShardedCache;
+
+//accesses of one shard in the current run, with the shard bits taken out, and the thread that runs them
+struct shard_run{
+  unsigned long long* addresses;
+  char* ops;
+  //number of every access in the run, which its requests to the next level are logged with
+  uint32_t* numbers;
+  size_t count;
+  //cache the shard belongs to, for its thread
+  ShardedCache* owner;
+  int shard;
+  pthread_t thread;
+};
+
+//returns 1 if a cache can be split into shards, a power of 2 from 2 to SHARD_MAX and no more than its sets
+int shardable(int blocksize, int size, int ass, double rep_policy, int shards);
+
+
+//Class that splits a cache by set index and runs the shards on threads of their own
+class ShardedCache : public Cache{
+ private:
+  int num_shards;
+  int shard_bits;
+  int block_bits;
+  //sets and ways of the whole cache
+  int total_sets;
+  int ways;
+  //mask of the set bits that pick the shard, above the block offset
+  unsigned long long shard_mask;
+  unsigned long long address_mask;
+  Cache** shards;
+  //requests of every shard for the next level, NULL when there is none
+  ShardLog** logs;
+  Cache* target;
+  //accesses collected for the next run, and the shard of each one
+  unsigned long long* addresses;
+  char* ops;
+  uint8_t* shard_of;
+  size_t count;
+  //accesses run before the current run, the LRFU time of its first access
+  int64_t clock;
+  struct shard_run runs[SHARD_MAX];
+  //the runs are started by moving generation on, and every thread but the calling one adds itself to finished
+  pthread_mutex_t lock;
+  pthread_cond_t started;
+  pthread_cond_t done;
+  uint64_t generation;
+  //threads that were started, they run shards 1 to workers
+  int workers;
+  int finished;
+  int stopping;
+  //runs the accesses of a shard
+  void run_shard(int shard);
+  static void* worker_main(void* arg);
+  //runs the collected accesses and sends the requests of the shards to the next level
+  void run();
+ public:
+  //takes the arguments of make_cache for the whole cache, and the number of shards
+  ShardedCache(int blocksize, int size, int ass, double rep_policy, int wr_policy, Cache* next_cache, int level, const char* name, int addr_bits, int shards);
+  ~ShardedCache();
+  void cache_in(unsigned long long address, char r_or_w);
+  void cache_in_batch(const unsigned long long* addresses, const char* ops, size_t count);
+  //the shards count a warm-up like any other run, and clear_stats clears them once it is over
+  void cache_warm(unsigned long long address, char r_or_w);
+  //runs every collected access, anything that looks at the next level has to call it first
+  void drain();
+  void calculate_stats();
+  void clear_stats();
+  void report(ContentsDump* out);
+};
+
+#endif
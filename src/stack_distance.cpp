@@ -0,0 +1,234 @@
+/**************************************************************************************************************************
+
+Filename: stack_distance.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the stack distance engine declared in stack_distance.h,
+and the curve mode of the simulator that prints a full LRU miss ratio curve from one pass over a trace.
+The curve mode can also run real LRU Cache instances at power of two associativities on the same accesses,
+to check that the curve matches what the cache model reports.
+
+****************************************************************************************************************************/
+
+#include "stack_distance.h"
+#include "cache.h"
+#include "trace.h"
+#include "trace_stream.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+//number of times a set starts out with
+#define SD_INITIAL_CAPACITY 64
+//largest associativity checked against the cache model
+#define SD_VERIFY_MAX 64
+
+
+//add value at position i of a Fenwick tree with capacity entries
+static inline void fenwick_add(uint32_t* tree, uint32_t capacity, uint32_t i, int value){
+  for(i++;i<=capacity;i+=i&(-i)) tree[i]+=value;
+}
+
+//sum of the first i entries of a Fenwick tree
+static inline uint32_t fenwick_prefix(const uint32_t* tree, uint32_t i){
+  uint32_t sum=0;
+  for(;i>0;i-=i&(-i)) sum+=tree[i];
+  return sum;
+}
+
+
+
+StackDistance::StackDistance(int blocksize, int sets){
+  block_bits=(int)log2(blocksize);
+  num_sets=sets;
+  this->sets=(struct sd_set*)calloc(num_sets,sizeof(struct sd_set));
+  last_access=new BlockMap(1024);
+  histogram_size=0;
+  histogram=NULL;
+  cold_misses=0;
+  accesses=0;
+}
+
+
+
+void StackDistance::clear_counts(){
+  if(histogram!=NULL) memset(histogram,0,histogram_size*sizeof(uint64_t));
+  cold_misses=0;
+  accesses=0;
+}
+
+
+
+StackDistance::~StackDistance(){
+  for(int i=0;i<num_sets;i++){
+    free(sets[i].tree);
+    free(sets[i].owner);
+  }
+  free(sets);
+  free(histogram);
+  delete last_access;
+}
+
+
+
+//pack the marked times of the set to the front and rebuild its tree
+void StackDistance::compact(struct sd_set* s){
+  uint32_t live=0;
+  uint32_t capacity=s->capacity;
+  //move the blocks that are still live to the front, keeping their order
+  for(uint32_t t=0;t<s->time;t++){
+    if(s->owner[t]==BLOCK_MAP_EMPTY) continue;
+    s->owner[live]=s->owner[t];
+    *last_access->find(s->owner[live])=live;
+    live++;
+  }
+  //grow the set if more than half of it is still live
+  if(capacity==0) capacity=SD_INITIAL_CAPACITY;
+  else if(2*live>capacity) capacity*=2;
+  if(capacity!=s->capacity){
+    s->owner=(uint64_t*)realloc(s->owner,capacity*sizeof(uint64_t));
+    free(s->tree);
+    s->tree=(uint32_t*)malloc((capacity+1)*sizeof(uint32_t));
+    s->capacity=capacity;
+  }
+  //rebuild the tree with a mark at each live time
+  memset(s->tree,0,(capacity+1)*sizeof(uint32_t));
+  for(uint32_t i=1;i<=live;i++) s->tree[i]=1;
+  for(uint32_t i=1;i<=capacity;i++){
+    uint32_t parent=i+(i&(-i));
+    if(parent<=capacity) s->tree[parent]+=s->tree[i];
+  }
+  s->time=live;
+  s->live=live;
+}
+
+
+
+//find the stack distance of the access and move its block to the top of the stack
+int64_t StackDistance::access(unsigned long long address){
+  uint64_t block=address>>block_bits;
+  struct sd_set* s=&sets[block&(uint64_t)(num_sets-1)];
+  uint64_t* last;
+  int64_t distance=-1;
+  uint32_t t;
+  if(s->time==s->capacity) compact(s);
+  t=s->time++;
+  accesses++;
+  last=last_access->find(block);
+  if(last!=NULL){
+    //count the blocks used since the last access
+    uint32_t previous=(uint32_t)*last;
+    distance=s->live-fenwick_prefix(s->tree,previous+1);
+    fenwick_add(s->tree,s->capacity,previous,-1);
+    s->owner[previous]=BLOCK_MAP_EMPTY;
+    *last=t;
+    //grow the histogram to hold the new distance
+    if((uint64_t)distance>=histogram_size){
+      uint64_t size=histogram_size==0 ? 64 : histogram_size;
+      while(size<=(uint64_t)distance) size*=2;
+      histogram=(uint64_t*)realloc(histogram,size*sizeof(uint64_t));
+      memset(histogram+histogram_size,0,(size-histogram_size)*sizeof(uint64_t));
+      histogram_size=size;
+    }
+    histogram[distance]++;
+  }
+  else{
+    cold_misses++;
+    s->live++;
+    last_access->insert(block,t);
+  }
+  fenwick_add(s->tree,s->capacity,t,1);
+  s->owner[t]=block;
+  return distance;
+}
+
+
+
+//every access with a distance of assoc or more misses, plus the cold misses
+uint64_t StackDistance::misses(uint64_t assoc){
+  uint64_t hits=0;
+  for(uint64_t d=0;d<assoc && d<histogram_size;d++) hits+=histogram[d];
+  return accesses-hits;
+}
+
+
+
+int run_curve(int block_size, int num_sets, const char* trace_path, uint64_t max_assoc, int verify){
+  TraceStream trace;
+  const uint64_t* batch;
+  size_t count;
+  uint64_t last_assoc;
+  uint64_t hits=0;
+  uint64_t curve_misses;
+  int num_checks=0;
+  int mismatches=0;
+  Cache* checks[8];
+  int check_assoc[8];
+  if(block_size<=0 || num_sets<=0 || (num_sets&(num_sets-1))!=0){
+    printf("The number of sets must be a power of two\n");
+    return 1;
+  }
+  if(!trace.open(trace_path)){
+    printf("Error opening file\n");
+    return 1;
+  }
+  StackDistance engine(block_size,num_sets);
+  //build LRU caches at power of two associativities to check the curve against
+  if(verify){
+    for(int assoc=1;assoc<=SD_VERIFY_MAX && (max_assoc==0 || (uint64_t)assoc<=max_assoc);assoc*=2){
+      checks[num_checks]=new Cache(block_size,block_size*num_sets*assoc,assoc,2,0,NULL,1,"L1",NULL);
+      check_assoc[num_checks]=assoc;
+      num_checks++;
+    }
+  }
+  while((count=trace.next_batch(&batch))>0){
+    for(size_t i=0;i<count;i++){
+      engine.access(trace_address(batch[i]));
+      for(int c=0;c<num_checks;c++) checks[c]->cache_in(trace_address(batch[i]),trace_op(batch[i]));
+    }
+  }
+  trace.close();
+
+  printf("===== Stack distance configuration =====\n");
+  printf("BLOCKSIZE:      %i\n",block_size);
+  printf("NUM_SETS:       %i\n",num_sets);
+  printf("trace_file:     %s\n",trace_path);
+  printf("========================================\n\n");
+  printf("accesses:       %llu\n",(unsigned long long)engine.get_accesses());
+  printf("cold misses:    %llu\n\n",(unsigned long long)engine.get_cold_misses());
+
+  //print the curve up to the first associativity where only cold misses are left
+  last_assoc=engine.max_assoc();
+  while(last_assoc>1 && engine.distance_count(last_assoc-1)==0) last_assoc--;
+  if(engine.max_assoc()==0) last_assoc=1;
+  if(max_assoc>0 && max_assoc<last_assoc) last_assoc=max_assoc;
+  printf("===== LRU miss ratio curve =====\n");
+  printf("%10s %14s %14s %10s\n","ASSOC","SIZE","MISSES","MISS_RATE");
+  for(uint64_t assoc=1;assoc<=last_assoc;assoc++){
+    hits+=engine.distance_count(assoc-1);
+    curve_misses=engine.get_accesses()-hits;
+    printf("%10llu %14llu %14llu %10.4f\n",(unsigned long long)assoc,(unsigned long long)assoc*num_sets*block_size,
+	   (unsigned long long)curve_misses,engine.get_accesses()>0 ? (double)curve_misses/(double)engine.get_accesses() : 0.0);
+  }
+
+  //compare the curve with the cache model
+  if(num_checks>0){
+    printf("\n===== Check against the LRU cache model =====\n");
+    printf("%10s %14s %14s %14s\n","ASSOC","CURVE_MISSES","CACHE_MISSES","RESULT");
+    for(int c=0;c<num_checks;c++){
+      struct cache_stats stats;
+      checks[c]->stats(&stats);
+      uint64_t cache_misses=stats.read_misses+stats.write_misses;
+      curve_misses=engine.misses(check_assoc[c]);
+      if(curve_misses!=cache_misses) mismatches++;
+      printf("%10i %14llu %14llu %14s\n",check_assoc[c],(unsigned long long)curve_misses,(unsigned long long)cache_misses,
+	     curve_misses==cache_misses ? "match" : "MISMATCH");
+      delete checks[c];
+    }
+  }
+  return mismatches>0;
+}
@@ -0,0 +1,78 @@
+/**************************************************************************************************************
+
+Filename:     stack_distance.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the stack distance class. It implements Mattson's stack
+algorithm for LRU caches. For a fixed block size and number of sets, the stack distance of an access is the
+number of distinct blocks of the same set that were used since the last access to its block. An LRU cache
+with an associativity of A hits exactly on the accesses with a stack distance below A, so one pass over the
+trace gives the miss ratio of every cache size with that block size and set count.
+
+Instead of keeping the LRU stack itself, every set keeps a Fenwick tree over its own access times. A time
+is marked while it is the most recent access to some block, so the stack distance is the number of marks
+between the last access to the block and now. Every mark is before now, so that is the number of distinct blocks
+of the set, kept as a count, less the marks up to the last access, found in O(log n). When a set runs out of times, the marked
+times are packed to the front so the memory stays proportional to the number of distinct blocks.
+
+*****************************************************************************************************************/
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+
+#include "block_map.h"
+#include <stdint.h>
+#include <stddef.h>
+
+//structure that holds the Fenwick tree and access times of one set
+struct sd_set{
+  uint32_t* tree;
+  //block that was accessed at each time, or BLOCK_MAP_EMPTY if that block has been used again since
+  uint64_t* owner;
+  uint32_t capacity;
+  uint32_t time;
+  //number of marked times, the distinct blocks of the set, which is also the sum of the whole tree
+  uint32_t live;
+};
+
+
+//Class that computes LRU stack distances for every set
+class StackDistance{
+ private:
+  int block_bits;
+  int num_sets;
+  struct sd_set* sets;
+  //maps a block address to the time of its last access in its set
+  BlockMap* last_access;
+  //count of accesses for each stack distance, grown as larger distances show up
+  uint64_t* histogram;
+  uint64_t histogram_size;
+  uint64_t cold_misses;
+  uint64_t accesses;
+  //packs the marked times of a set to the front, growing it if it is more than half full
+  void compact(struct sd_set* s);
+ public:
+  StackDistance(int blocksize, int sets);
+  ~StackDistance();
+  //processes one access and returns its stack distance, or -1 for the first access to a block
+  int64_t access(unsigned long long address);
+  //number of misses an LRU cache with the given associativity would have
+  uint64_t misses(uint64_t assoc);
+  //smallest associativity that only has cold misses
+  uint64_t max_assoc(){ return histogram_size; }
+  uint64_t get_accesses(){ return accesses; }
+  uint64_t get_cold_misses(){ return cold_misses; }
+  uint64_t distance_count(uint64_t distance){ return distance<histogram_size ? histogram[distance] : 0; }
+  //sets the counts back to 0, for the end of a warm-up, the blocks and their last accesses are kept
+  void clear_counts();
+};
+
+//runs the stack distance engine over a trace and prints the miss ratio curve
+int run_curve(int block_size, int num_sets, const char* trace_path, uint64_t max_assoc, int verify);
+
+#endif
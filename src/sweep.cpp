@@ -0,0 +1,247 @@
+/**************************************************************************************************************************
+
+Filename: sweep.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the sweep mode declared in sweep.h.
+The trace is decoded ahead on the producer thread of a trace stream, and the main thread hands each batch
+to the worker threads and takes the next one while they simulate it. Each worker owns a fixed group of hierarchies, so every hierarchy still sees
+the accesses in trace order and the results match separate runs of sim_cache exactly. Two barriers
+separate the batches: one to hand a batch to the workers and one to wait for them to finish it.
+
+****************************************************************************************************************************/
+
+#include "sweep.h"
+#include "hierarchy.h"
+#include "trace.h"
+#include "trace_stream.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+
+//state shared between the producer and the workers
+struct sweep_state{
+  Hierarchy** hierarchies;
+  int num_configs;
+  int num_threads;
+  //batch the workers are currently simulating
+  const uint64_t* batch;
+  size_t count;
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+};
+
+//what each worker is handed when it is created
+struct sweep_worker{
+  struct sweep_state* state;
+  int id;
+};
+
+
+
+//worker thread, simulates every num_threads-th hierarchy starting at its id
+static void* sweep_worker_main(void* arg){
+  struct sweep_worker* worker=(struct sweep_worker*)arg;
+  struct sweep_state* state=worker->state;
+  for(;;){
+    pthread_barrier_wait(&state->start);
+    //an empty batch means the trace is done
+    if(state->count==0) break;
+    for(int i=worker->id;i<state->num_configs;i+=state->num_threads){
+      state->hierarchies[i]->run_batch(state->batch,state->count);
+    }
+    pthread_barrier_wait(&state->done);
+  }
+  return NULL;
+}
+
+
+
+//the REPL column, the name of a policy that has one and the number of LRU, LFU and the lambda of LRFU
+static void replacement_text(double replacement, char* text, size_t size){
+  const char* name=replacement_arg_name(replace_policy_of(replacement));
+  if(name!=NULL && replacement<0) snprintf(text,size,"%s",name);
+  else snprintf(text,size,"%g",replacement);
+}
+
+
+
+//read the configuration file, returns the number of configurations
+static int read_configs(const char* path, struct hierarchy_config** configs){
+  FILE* file;
+  char LINE_IN[1024];
+  char* params[HIERARCHY_PARAMS+1];
+  int num=0;
+  //line of the file, for the messages about the lines that are skipped
+  int line=0;
+  int max=16;
+  int found;
+  file=fopen(path,"r");
+  if(file==NULL) return -1;
+  *configs=(struct hierarchy_config*)malloc(max*sizeof(struct hierarchy_config));
+  while(fgets(LINE_IN,1024,file)!=NULL){
+    line++;
+    //split the line on whitespace
+    found=0;
+    for(char* tok=strtok(LINE_IN," \t\r\n");tok!=NULL && found<=HIERARCHY_PARAMS;tok=strtok(NULL," \t\r\n")){
+      if(found==0 && tok[0]=='#') break;
+      params[found++]=tok;
+    }
+    if(found==0) continue;
+    if(found<HIERARCHY_PARAMS){
+      printf("Skipping incomplete configuration line %i\n",line);
+      continue;
+    }
+    if(num==max){
+      max*=2;
+      *configs=(struct hierarchy_config*)realloc(*configs,max*sizeof(struct hierarchy_config));
+    }
+    hierarchy_parse_config(params,&(*configs)[num]);
+    //an optional last column gives the physical address width
+    if(found>HIERARCHY_PARAMS) (*configs)[num].address_bits=atoi(params[HIERARCHY_PARAMS]);
+    if((*configs)[num].address_bits<1 || (*configs)[num].address_bits>64){
+      printf("Skipping configuration line %i, the address width must be between 1 and 64 bits\n",line);
+      continue;
+    }
+    num++;
+  }
+  fclose(file);
+  return num;
+}
+
+
+
+int run_sweep(const char* config_path, const char* trace_path, int threads, double sample_fraction){
+  struct sweep_state state;
+  struct hierarchy_config* configs=NULL;
+  struct sweep_worker* workers;
+  pthread_t* handles;
+  TraceStream trace;
+  const uint64_t* batch;
+  size_t count;
+  unsigned long long total=0;
+  struct timeval begin,end;
+  double seconds;
+  int num_configs;
+
+  num_configs=read_configs(config_path,&configs);
+  if(num_configs<0){
+    printf("Error opening configuration file\n");
+    return 1;
+  }
+  //set sampling cannot split up a victim cache, so those configurations are left out
+  if(sample_fraction>0){
+    int kept=0;
+    for(int i=0;i<num_configs;i++){
+      if(configs[i].vc_size>0){
+	printf("Skipping configuration %i, set sampling does not support a victim cache\n",i+1);
+	continue;
+      }
+      configs[kept]=configs[i];
+      configs[kept].sample_fraction=sample_fraction;
+      kept++;
+    }
+    num_configs=kept;
+  }
+  if(num_configs==0){
+    printf("No configurations to simulate\n");
+    free(configs);
+    return 1;
+  }
+  if(!trace.open(trace_path)){
+    printf("Error opening file\n");
+    free(configs);
+    return 1;
+  }
+  if(threads<=0) threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+  if(threads<1) threads=1;
+  if(threads>num_configs) threads=num_configs;
+
+  //build every hierarchy
+  state.num_configs=num_configs;
+  state.num_threads=threads;
+  state.hierarchies=(Hierarchy**)malloc(num_configs*sizeof(Hierarchy*));
+  for(int i=0;i<num_configs;i++) state.hierarchies[i]=new Hierarchy(&configs[i]);
+
+  printf("===== Sweep configuration =====\n");
+  printf("configurations:   %i\n",num_configs);
+  printf("threads:          %i\n",threads);
+  printf("trace_file:       %s\n",trace_path);
+  if(sample_fraction>0) printf("sampled sets:     %.2f%%\n",100.0*sample_fraction);
+  printf("===============================\n\n");
+
+  gettimeofday(&begin,NULL);
+  pthread_barrier_init(&state.start,NULL,threads+1);
+  pthread_barrier_init(&state.done,NULL,threads+1);
+  workers=(struct sweep_worker*)malloc(threads*sizeof(struct sweep_worker));
+  handles=(pthread_t*)malloc(threads*sizeof(pthread_t));
+  for(int i=0;i<threads;i++){
+    workers[i].state=&state;
+    workers[i].id=i;
+    pthread_create(&handles[i],NULL,sweep_worker_main,&workers[i]);
+  }
+
+  //take the first batch, the trace stream keeps it valid while the next one is taken
+  count=trace.next_batch(&batch);
+  for(;;){
+    //hand the batch to the workers
+    state.batch=batch;
+    state.count=count;
+    total+=count;
+    pthread_barrier_wait(&state.start);
+    if(count==0) break;
+    //take the next batch while the workers simulate this one
+    count=trace.next_batch(&batch);
+    pthread_barrier_wait(&state.done);
+  }
+  for(int i=0;i<threads;i++) pthread_join(handles[i],NULL);
+  gettimeofday(&end,NULL);
+  seconds=(double)(end.tv_sec-begin.tv_sec)+(double)(end.tv_usec-begin.tv_usec)/1000000.0;
+
+  //print one row per configuration
+  printf("%4s %6s %8s %5s %8s %8s %5s %9s | %9s %7s %9s %9s %9s %10s %10s\n",
+	 "#","BLK","L1_SIZE","L1_A","VC_SIZE","L2_SIZE","L2_A","REPL",
+	 "L1_MISS","SWAPS","VC_WB","L2_MISS","L2_WB","MEM_TRAF","AAT_NS");
+  for(int i=0;i<num_configs;i++){
+    Hierarchy* h=state.hierarchies[i];
+    char repl[16];
+    h->calculate_stats();
+    replacement_text(h->config.replacement,repl,sizeof(repl));
+    //sampled hierarchies print their estimates in the same columns
+    if(h->sampler!=NULL){
+      struct sampled_stats stats;
+      h->estimate(&stats);
+      printf("%4i %6i %8i %5i %8i %8i %5i %9s | %9.4f %7i %9i %9.4f %9.0f %10.0f %10.4f\n",
+	     i+1,h->config.block_size,h->config.l1_size,h->config.l1_assoc,h->config.vc_size,
+	     h->config.l2_size,h->config.l2_assoc,repl,
+	     stats.l1_miss_rate.value,0,0,h->second!=NULL ? stats.l2_miss_rate.value : 0.0,
+	     stats.l2_write_backs.value,stats.memory_traffic.value,stats.average_access_time);
+      continue;
+    }
+    struct hierarchy_stats all;
+    h->stats(&all);
+    printf("%4i %6i %8i %5i %8i %8i %5i %9s | %9.4f %7llu %9llu %9.4f %9llu %10llu %10.4f\n",
+	   i+1,h->config.block_size,h->config.l1_size,h->config.l1_assoc,h->config.vc_size,
+	   h->config.l2_size,h->config.l2_assoc,repl,
+	   all.l1.miss_rate,(unsigned long long)all.l1.swaps,(unsigned long long)all.victim.write_backs,all.l2.miss_rate,
+	   (unsigned long long)all.l2.write_backs,(unsigned long long)all.memory_traffic,(float)all.average_access_time);
+  }
+  printf("\nsimulated %llu accesses for %i configurations in %.3f s\n",total,num_configs,seconds);
+  if(sample_fraction>0) printf("results are estimated from a sample of the sets\n");
+
+  pthread_barrier_destroy(&state.start);
+  pthread_barrier_destroy(&state.done);
+  for(int i=0;i<num_configs;i++) delete state.hierarchies[i];
+  free(state.hierarchies);
+  free(workers);
+  free(handles);
+  free(configs);
+  return 0;
+}
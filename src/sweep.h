@@ -0,0 +1,30 @@
+/**************************************************************************************************************
+
+Filename:     sweep.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the sweep mode of the simulator. A sweep simulates many
+hierarchy configurations on the same trace in one run. The trace is decoded once, and every batch of
+accesses is fed to all of the hierarchies, which are split across a pool of worker threads. The results
+of every configuration are printed in one table at the end.
+
+A sweep configuration file has one hierarchy per line with the same 7 parameters that sim_cache takes on
+the command line: L1_BLOCKSIZE L1_SIZE L1_ASSOC Victim_Cache_SIZE L2_SIZE L2_ASSOC REPLACEMENT, optionally
+followed by the physical address width in bits. Blank lines and lines starting with # are skipped. A sampled sweep prints estimated results, see sample.h,
+and skips the configurations with a victim cache.
+
+*****************************************************************************************************************/
+#ifndef SWEEP_H
+#define SWEEP_H
+
+//runs every configuration in config_path on the trace, threads of 0 uses one thread per core,
+//a sample_fraction above 0 simulates only that fraction of the sets of every configuration
+int run_sweep(const char* config_path, const char* trace_path, int threads, double sample_fraction);
+
+#endif
@@ -0,0 +1,236 @@
+/**************************************************************************************************************************
+
+Filename: trace.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the trace reader declared in trace.h.
+When a trace is opened the first bytes of the file are checked for the binary magic string. Binary traces
+are mapped into memory and their records are handed out directly from the mapping, so no copy or parse is needed.
+Text traces and compressed traces are read through zlib. Text is read in large chunks and each line is parsed
+into a packed record in an internal buffer, and compressed binary records are decompressed into the buffer.
+
+****************************************************************************************************************************/
+
+#include "trace.h"
+#include "generator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+//parse one line of a text trace, the first character is the op and a hex address follows, with or without 0x
+int trace_parse_line(const char* line, uint64_t* record){
+  unsigned long long address=0;
+  char r_or_w=line[0];
+  int digits=0;
+  const char* c=line+1;
+  //blank lines do not hold an access
+  if(r_or_w=='\n' || r_or_w=='\r' || r_or_w=='\0') return 0;
+  while(*c==' ' || *c=='\t') c++;
+  if(c[0]=='0' && (c[1]=='x' || c[1]=='X')) c+=2;
+  //read in the hex address
+  for(;;c++){
+    if(*c>='0' && *c<='9') address=(address<<4)|(unsigned long long)(*c-'0');
+    else if(*c>='a' && *c<='f') address=(address<<4)|(unsigned long long)(*c-'a'+10);
+    else if(*c>='A' && *c<='F') address=(address<<4)|(unsigned long long)(*c-'A'+10);
+    else break;
+    digits++;
+  }
+  //an address has to end with the line or before whitespace, anything else is not an address
+  if(digits==0 || (*c!='\0' && *c!=' ' && *c!='\t' && *c!='\n' && *c!='\r')) return 0;
+  *record=trace_pack(address,r_or_w);
+  return 1;
+}
+
+
+
+Trace::Trace(){
+  format=TRACE_TEXT;
+  file=NULL;
+  buffer=NULL;
+  text=NULL;
+  text_used=0;
+  text_size=0;
+  text_end=0;
+  generator=NULL;
+  map=NULL;
+  map_size=0;
+  records=NULL;
+  num_records=0;
+  position=0;
+}
+
+
+
+Trace::~Trace(){
+  close();
+}
+
+
+
+//open the trace and figure out what format it is in
+int Trace::open(const char* path){
+  struct trace_header header;
+  struct stat info;
+  int fd;
+  int got;
+  close();
+  //a generator makes its accesses up instead of reading them
+  if(is_generator(path)){
+    generator=new Generator();
+    if(!generator->open(path+GEN_PREFIX_LEN)){
+      delete generator;
+      generator=NULL;
+      return 0;
+    }
+    format=TRACE_GENERATED;
+    buffer=(uint64_t*)malloc(TRACE_BATCH*sizeof(uint64_t));
+    return 1;
+  }
+  fd=::open(path,O_RDONLY);
+  if(fd<0) return 0;
+  //check for the binary magic string
+  if(fstat(fd,&info)==0 && (size_t)info.st_size>=sizeof(header) && pread(fd,&header,sizeof(header),0)==(ssize_t)sizeof(header)
+     && memcmp(header.magic,TRACE_MAGIC,TRACE_MAGIC_LEN)==0){
+    format=TRACE_BINARY;
+    map_size=info.st_size;
+    map=mmap(NULL,map_size,PROT_READ,MAP_PRIVATE,fd,0);
+    ::close(fd);
+    if(map==MAP_FAILED){
+      map=NULL;
+      return 0;
+    }
+    //the trace is read front to back once
+    madvise(map,map_size,MADV_SEQUENTIAL);
+    records=(const uint64_t*)((const char*)map+sizeof(header));
+    num_records=header.num_records;
+    //do not trust a count that runs past the end of the file
+    if(num_records>(map_size-sizeof(header))/sizeof(uint64_t)) num_records=(map_size-sizeof(header))/sizeof(uint64_t);
+    position=0;
+    return 1;
+  }
+  //otherwise read it through zlib, which also reads files that are not compressed
+  file=gzdopen(fd,"rb");
+  if(file==NULL){
+    ::close(fd);
+    return 0;
+  }
+  gzbuffer(file,TRACE_TEXT_CHUNK);
+  buffer=(uint64_t*)malloc(TRACE_BATCH*sizeof(uint64_t));
+  //look for the binary magic string in the decompressed bytes
+  text=(char*)malloc(TRACE_TEXT_CHUNK+1);
+  got=gzread(file,text,sizeof(header));
+  if(got==(int)sizeof(header) && memcmp(text,TRACE_MAGIC,TRACE_MAGIC_LEN)==0){
+    format=TRACE_BINARY;
+    memcpy(&header,text,sizeof(header));
+    num_records=header.num_records;
+    position=0;
+    free(text);
+    text=NULL;
+    return 1;
+  }
+  //it is a text trace, and the bytes read so far are the start of it
+  format=TRACE_TEXT;
+  text_used=0;
+  text_size=got>0 ? got : 0;
+  text_end=0;
+  return 1;
+}
+
+
+
+//parse lines out of the text read in so far, reading more as each chunk runs out
+size_t Trace::parse_text(uint64_t* out){
+  size_t count=0;
+  while(count<TRACE_BATCH){
+    char* line=text+text_used;
+    char* end=(char*)memchr(line,'\n',text_size-text_used);
+    if(end==NULL){
+      size_t left=text_size-text_used;
+      int got=0;
+      //the last line of the trace may not end in a newline
+      if(text_end){
+	if(left==0) break;
+	text[text_size]='\0';
+	if(trace_parse_line(line,&out[count])) count++;
+	text_used=text_size;
+	break;
+      }
+      //move the partial line to the front and read in the rest of the chunk
+      memmove(text,line,left);
+      text_used=0;
+      text_size=left;
+      //a line as long as a whole chunk is not an access, drop it
+      if(left==TRACE_TEXT_CHUNK) text_size=0;
+      got=gzread(file,text+text_size,TRACE_TEXT_CHUNK-text_size);
+      if(got<=0) text_end=1;
+      else text_size+=got;
+      continue;
+    }
+    *end='\0';
+    if(trace_parse_line(line,&out[count])) count++;
+    text_used=end-text+1;
+  }
+  return count;
+}
+
+
+
+//hand out the next batch of records
+size_t Trace::next_batch(const uint64_t** batch){
+  return next_batch_into(buffer,batch);
+}
+
+
+
+size_t Trace::next_batch_into(uint64_t* out, const uint64_t** batch){
+  size_t count=0;
+  if(map!=NULL){
+    //point straight into the mapping
+    count=num_records-position;
+    if(count>TRACE_BATCH) count=TRACE_BATCH;
+    *batch=records+position;
+    position+=count;
+    return count;
+  }
+  if(generator!=NULL){
+    *batch=out;
+    return generator->fill(out,TRACE_BATCH);
+  }
+  if(file==NULL) return 0;
+  *batch=out;
+  if(format==TRACE_TEXT) return parse_text(out);
+  //decompress the records of a binary trace, stopping at the count in the header
+  count=num_records-position;
+  if(count>TRACE_BATCH) count=TRACE_BATCH;
+  if(count==0) return 0;
+  int got=gzread(file,out,count*sizeof(uint64_t));
+  count=got>0 ? got/sizeof(uint64_t) : 0;
+  position+=count;
+  return count;
+}
+
+
+
+void Trace::close(){
+  if(file!=NULL) gzclose(file);
+  if(buffer!=NULL) free(buffer);
+  if(text!=NULL) free(text);
+  if(map!=NULL) munmap(map,map_size);
+  if(generator!=NULL) delete generator;
+  generator=NULL;
+  file=NULL;
+  buffer=NULL;
+  text=NULL;
+  map=NULL;
+  map_size=0;
+  records=NULL;
+  num_records=0;
+  position=0;
+}
@@ -0,0 +1,118 @@
+/**************************************************************************************************************
+
+Filename:     trace.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the trace reader. A trace can be stored in one of two formats.
+The text format is the original one, with one "r <hex address>" or "w <hex address>" access per line.
+The binary format is a fixed width format made for very large traces. It starts with a small header
+(an 8 byte magic string and the number of records), followed by one 64 bit record per access. The top bit
+of a record is the op bit (1 for a write, 0 for a read) and the low 63 bits hold the address.
+
+Binary traces are read zero-copy by mapping the file into memory with mmap, text traces are parsed into an
+internal buffer of packed records. In both cases the simulator asks for batches of packed records, so the
+code that drives the caches does not need to know which format the trace was stored in.
+
+Either format can also be compressed with gzip. Anything that is not a plain binary trace is read through zlib,
+which passes uncompressed files through untouched, and the format is detected from the decompressed bytes.
+Compressed binary traces cannot be mapped, so their records are decompressed straight into the buffer.
+
+A trace name starting with "gen:" does not name a file, it selects a synthetic workload generator, see
+generator.h, whose accesses are made into the buffer a batch at a time.
+
+*****************************************************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <zlib.h>
+
+class Generator;
+
+//magic string at the start of every binary trace
+#define TRACE_MAGIC "CSIMTRC1"
+#define TRACE_MAGIC_LEN 8
+
+//bit used to hold the op in a packed record
+#define TRACE_WRITE_BIT 0x8000000000000000ULL
+#define TRACE_ADDRESS_MASK 0x7FFFFFFFFFFFFFFFULL
+
+//number of records handed out per batch
+#define TRACE_BATCH 65536
+//bytes of a text trace read in at once
+#define TRACE_TEXT_CHUNK (1<<20)
+
+//formats a trace file can be in
+#define TRACE_TEXT 0
+#define TRACE_BINARY 1
+#define TRACE_GENERATED 2
+
+//header at the start of a binary trace
+struct trace_header{
+  char magic[TRACE_MAGIC_LEN];
+  uint64_t num_records;
+};
+
+//helper functions to pack and unpack a record
+inline uint64_t trace_pack(unsigned long long address, char r_or_w){
+  return (address&TRACE_ADDRESS_MASK)|(r_or_w=='r' ? 0 : TRACE_WRITE_BIT);
+}
+inline unsigned long long trace_address(uint64_t record){
+  return record&TRACE_ADDRESS_MASK;
+}
+inline char trace_op(uint64_t record){
+  return (record&TRACE_WRITE_BIT) ? 'w' : 'r';
+}
+
+//parses one line of a text trace into a packed record, the address may start with 0x, returns 0 if the line holds
+//no access, or if its address does not end with the line or before whitespace
+int trace_parse_line(const char* line, uint64_t* record);
+
+
+//Class that reads a trace in either format
+class Trace{
+ private:
+  int format;
+  //used for text traces and compressed binary traces
+  gzFile file;
+  uint64_t* buffer;
+  //text read in but not parsed yet, text_used bytes of text_size are done
+  char* text;
+  size_t text_used;
+  size_t text_size;
+  int text_end;
+  //used for generated traces
+  Generator* generator;
+  //used for binary traces
+  void* map;
+  size_t map_size;
+  const uint64_t* records;
+  uint64_t num_records;
+  uint64_t position;
+  //parses lines of a text trace into out until it is full or the trace ends
+  size_t parse_text(uint64_t* out);
+ public:
+  Trace();
+  ~Trace();
+  //opens a trace and detects its format, returns 0 on failure
+  int open(const char* path);
+  //points batch at the next packed records and returns how many there are, 0 at the end of the trace
+  size_t next_batch(const uint64_t** batch);
+  //same as next_batch, but text, compressed and generated records are decoded into out, which holds TRACE_BATCH records,
+  //binary records are still handed out from the mapping
+  size_t next_batch_into(uint64_t* out, const uint64_t** batch);
+  //1 if the batches point into a mapping of the file
+  int is_mapped(){ return map!=NULL; }
+  void close();
+  int get_format(){ return format; }
+};
+
+#endif
@@ -0,0 +1,62 @@
+/*************************************************************************************************
+
+Filename: trace_convert.cpp
+
+Date Modified: 10/18/2026
+
+Author: Kevin Volkel
+
+Description: This file is the main file for the trace converter. It reads a text trace with one
+"r <hex address>" or "w <hex address>" access per line, which may be compressed with gzip, and writes it
+out in the binary trace format described in trace.h. The simulator detects binary traces on its own, so a converted trace can be passed
+to sim_cache in place of the text trace.
+
+usage: trace_convert <text_trace> <binary_trace>
+
+*****************************************************************************************************/
+#include "trace.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+
+int main(int argc, char** argv){
+  Trace in;
+  FILE* out;
+  struct trace_header header;
+  const uint64_t* batch;
+  size_t count;
+  uint64_t total=0;
+  if(argc<3){
+    printf("usage: %s <text_trace> <binary_trace>\n",argv[0]);
+    return 1;
+  }
+  if(!in.open(argv[1])){
+    printf("Error opening file\n");
+    return 1;
+  }
+  out=fopen(argv[2],"wb");
+  if(out==NULL){
+    printf("Error opening output file\n");
+    return 1;
+  }
+  //write a placeholder header, the record count is filled in at the end
+  memcpy(header.magic,TRACE_MAGIC,TRACE_MAGIC_LEN);
+  header.num_records=0;
+  fwrite(&header,sizeof(header),1,out);
+  //the reader parses the text, and decompresses it first if it is compressed
+  while((count=in.next_batch(&batch))>0){
+    fwrite(batch,sizeof(uint64_t),count,out);
+    total+=count;
+  }
+  //go back and fill in the number of records
+  header.num_records=total;
+  fseek(out,0,SEEK_SET);
+  fwrite(&header,sizeof(header),1,out);
+  fclose(out);
+  in.close();
+  printf("converted %llu accesses\n",(unsigned long long)total);
+  return 0;
+}
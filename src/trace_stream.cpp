@@ -0,0 +1,142 @@
+/**************************************************************************************************************************
+
+Filename: trace_stream.cpp
+
+Date modified: 10/18/26
+
+Author Kevin Volkel
+
+Description: This file contains the implementation of the trace stream declared in trace_stream.h.
+Batch n of the trace goes in buffer n%TRACE_RING. The counters made, taken and freed only grow, the producer
+can fill a buffer while fewer than TRACE_RING batches are made but not freed, and the consumer frees every
+batch but the last one it took each time it asks for a new one. The counters are guarded by one mutex, which is
+locked once per batch of TRACE_BATCH records, so it is never contended for long.
+
+****************************************************************************************************************************/
+
+#include "trace_stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//records per page of a mapped trace
+#define TRACE_PAGE_RECORDS 512
+
+
+TraceStream::TraceStream(){
+  running=0;
+  stop=0;
+  made=0;
+  taken=0;
+  freed=0;
+  for(int i=0;i<TRACE_RING;i++) buffers[i]=NULL;
+  pthread_mutex_init(&lock,NULL);
+  pthread_cond_init(&filled,NULL);
+  pthread_cond_init(&emptied,NULL);
+}
+
+
+
+TraceStream::~TraceStream(){
+  close();
+  pthread_mutex_destroy(&lock);
+  pthread_cond_destroy(&filled);
+  pthread_cond_destroy(&emptied);
+}
+
+
+
+int TraceStream::open(const char* path){
+  close();
+  if(!trace.open(path)) return 0;
+  //mapped traces are handed out from the mapping, so they do not need buffers
+  if(!trace.is_mapped()){
+    for(int i=0;i<TRACE_RING;i++) buffers[i]=(uint64_t*)malloc(TRACE_BATCH*sizeof(uint64_t));
+  }
+  made=0;
+  taken=0;
+  freed=0;
+  stop=0;
+  running=1;
+  threaded=sysconf(_SC_NPROCESSORS_ONLN)>1;
+  if(threaded) pthread_create(&producer,NULL,produce,this);
+  return 1;
+}
+
+
+
+//producer thread, decodes batches until the trace ends or it is told to stop
+void* TraceStream::produce(void* arg){
+  TraceStream* stream=(TraceStream*)arg;
+  volatile uint64_t touched=0;
+  for(;;){
+    pthread_mutex_lock(&stream->lock);
+    while(stream->made-stream->freed==TRACE_RING && !stream->stop) pthread_cond_wait(&stream->emptied,&stream->lock);
+    if(stream->stop){
+      pthread_mutex_unlock(&stream->lock);
+      break;
+    }
+    int slot=(int)(stream->made%TRACE_RING);
+    pthread_mutex_unlock(&stream->lock);
+    //the buffer is free, so it can be filled without the lock
+    size_t count=stream->trace.next_batch_into(stream->buffers[slot],&stream->batches[slot]);
+    if(stream->buffers[slot]==NULL){
+      //fault the pages of a mapped batch in here instead of on the simulation thread
+      for(size_t i=0;i<count;i+=TRACE_PAGE_RECORDS) touched+=stream->batches[slot][i];
+    }
+    pthread_mutex_lock(&stream->lock);
+    stream->counts[slot]=count;
+    stream->made++;
+    pthread_cond_signal(&stream->filled);
+    pthread_mutex_unlock(&stream->lock);
+    //an empty batch marks the end of the trace
+    if(count==0) break;
+  }
+  return NULL;
+}
+
+
+
+size_t TraceStream::next_batch(const uint64_t** batch){
+  size_t count;
+  if(!running) return 0;
+  //decode the batch right here, rotating through the buffers so the last batch stays valid
+  if(!threaded){
+    int slot=(int)(taken%TRACE_RING);
+    count=trace.next_batch_into(buffers[slot],batch);
+    if(count>0) taken++;
+    return count;
+  }
+  pthread_mutex_lock(&lock);
+  //every batch but the last one taken can be reused
+  if(taken>0 && freed<taken-1){
+    freed=taken-1;
+    pthread_cond_signal(&emptied);
+  }
+  while(made==taken) pthread_cond_wait(&filled,&lock);
+  int slot=(int)(taken%TRACE_RING);
+  *batch=batches[slot];
+  count=counts[slot];
+  //the end of the trace is not taken, so asking again keeps returning 0
+  if(count>0) taken++;
+  pthread_mutex_unlock(&lock);
+  return count;
+}
+
+
+
+void TraceStream::close(){
+  if(running && threaded){
+    pthread_mutex_lock(&lock);
+    stop=1;
+    pthread_cond_signal(&emptied);
+    pthread_mutex_unlock(&lock);
+    pthread_join(producer,NULL);
+  }
+  running=0;
+  trace.close();
+  for(int i=0;i<TRACE_RING;i++){
+    free(buffers[i]);
+    buffers[i]=NULL;
+  }
+}
@@ -0,0 +1,71 @@
+/**************************************************************************************************************
+
+Filename:     trace_stream.h
+
+
+Date Modified: 10/18/26
+
+
+Author: Kevin Volkel
+
+
+Description: This file is the header file for the trace stream. A trace stream reads a trace on its own
+producer thread, so reading, decompressing and parsing the trace overlap with the simulation instead of
+running between its batches. Decoded batches are passed to the simulation through a single producer, single
+consumer ring of TRACE_RING buffers. When the simulation gets ahead of the producer it waits for the next
+batch, and when the producer gets ahead it waits for a free buffer.
+
+Binary traces that are mapped into memory are not copied into the ring, the producer touches one record per
+page of the next batches so the page faults happen on its thread, and hands out pointers into the mapping.
+
+A batch stays valid until next_batch has been called twice more, so the caller can simulate one batch while
+asking for the next, like the sweep mode does. With only one core online a producer thread would just take
+turns with the simulation, so the batches are decoded on the calling thread instead, into the same buffers.
+
+*****************************************************************************************************************/
+#ifndef TRACE_STREAM_H
+#define TRACE_STREAM_H
+
+#include "trace.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+//number of batches in the ring
+#define TRACE_RING 8
+
+
+//Class that reads a trace ahead on a producer thread
+class TraceStream{
+ private:
+  Trace trace;
+  pthread_t producer;
+  int running;
+  //0 when there is only one core, then batches are decoded on the calling thread when they are asked for
+  int threaded;
+  //set to tell the producer to stop early
+  int stop;
+  uint64_t* buffers[TRACE_RING];
+  const uint64_t* batches[TRACE_RING];
+  size_t counts[TRACE_RING];
+  //batches made by the producer, handed to the consumer, and given back by it
+  uint64_t made;
+  uint64_t taken;
+  uint64_t freed;
+  pthread_mutex_t lock;
+  pthread_cond_t filled;
+  pthread_cond_t emptied;
+  static void* produce(void* arg);
+ public:
+  TraceStream();
+  ~TraceStream();
+  //opens a trace and starts the producer, returns 0 on failure
+  int open(const char* path);
+  //points batch at the next packed records and returns how many there are, 0 at the end of the trace
+  size_t next_batch(const uint64_t** batch);
+  //stops the producer and closes the trace
+  void close();
+  int get_format(){ return trace.get_format(); }
+};
+
+#endif